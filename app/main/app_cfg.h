@@ -24,12 +24,22 @@ typedef uint32_t board_id_t;
 
 // task priorities
 #define UI_TASK_PRIO 1
+#define SEQUENCER_TASK_PRIO 2
+#define SWMATRIX_TASK_PRIO 3
 #define MAIN_TASK_PRIO (OS_LOWEST_PRIO - 3)
 #define OS_TASK_TMR_PRIO (OS_LOWEST_PRIO - 2)
+// OS_TASK_STAT_EN is 0, the statistics task priority is free
+#define ENVMON_TASK_PRIO (OS_LOWEST_PRIO - 1)
+#define TELEMETRY_TASK_PRIO (OS_LOWEST_PRIO - 4)
 
-// stack sizes
+// stack sizes, the link fails unless __stack_reserve bytes of RAM stay free
+// above the static data (board link.x)
 #define UI_TASK_STACK_SIZE 1000
 #define MAIN_TASK_STACK_SIZE 1000
+#define SEQUENCER_TASK_STACK_SIZE 320
+#define SWMATRIX_TASK_STACK_SIZE 320
+#define ENVMON_TASK_STACK_SIZE 300
+#define TELEMETRY_TASK_STACK_SIZE 300
 
 // board and drivers features configuration
 
@@ -46,12 +56,67 @@ typedef uint32_t board_id_t;
 #define CONSOLE_FIFO_SIZE 32
 #define CONSOLE_USART 0
 #define CONSOLE_USART_BAUDRATE 115200
+// console input is received by DMA into two blocks, an incomplete block is
+// passed on when nothing arrived for SERIAL_RX_DMA_FLUSH_TICKS, when idle the
+// RX pin (port INT1) wakes the reader
+#define SERIAL_RX_DMA_BLOCK 16
+#define SERIAL_RX_DMA_FLUSH_TICKS 1
 
 // Editor configuration
 
 #define EDITOR_LINE_SIZE 77
 #define EDITOR_BUFFER_SIZE 512
 
+// Switch chain configuration
+// The waveform and the images take 19 bytes of RAM per chip, the chain
+// length configured at runtime (MATRIX.GEOMETRY) can't exceed
+// SWCHAIN_MAX_CHIPS. 2048 channels take 256 chips.
+// The settle times and the actuation counters are kept in EEPROM for the
+// first SWSETTLE_MAX_ROWS rows and SWCOUNTER_MAX_CHIPS chips only.
+
+#define SWCHAIN_MAX_CHIPS 64
+#define SWSETTLE_MAX_ROWS 64
+#define SWCOUNTER_MAX_CHIPS 64
+
+// Matrix task configuration
+
+#define SWMATRIX_QUEUE_SIZE 8
+
+// Sequencer configuration
+
+#define SEQUENCER_MAX_STEPS 64
+
+// Actuation counters configuration
+// The counts are written to EEPROM by the matrix task once no switch changed
+// for SWCOUNTER_IDLE_S, at the latest every SWCOUNTER_FLUSH_PERIOD_S, and not
+// earlier than SWCOUNTER_MIN_FLUSH_S when a counter gets close to overflow.
+
+#define SWCOUNTER_IDLE_S 600
+#define SWCOUNTER_FLUSH_PERIOD_S 14400UL
+#define SWCOUNTER_MIN_FLUSH_S 10
+
+// Trigger configuration
+
+#define TRIGGER_MAX_CHANNELS 64
+
+// Schedule configuration
+
+#define SWSCHED_MAX_ACTIONS 4
+
+// Environment monitor configuration
+
+#define ENVMON_PERIOD_S 10
+// samples of the history, one every ENVMON_HISTORY_EVERY periods (32 min),
+// 8 bytes of RAM each
+#define ENVMON_HISTORY_SIZE 32
+#define ENVMON_HISTORY_EVERY 6
+
+// Telemetry configuration
+
+// period of the check for changes
+#define TELEMETRY_POLL_MS 20
+#define TELEMETRY_MAX_INTERVAL_MS 60000
+
 // Debug configuration
 
 #define DEBUG_USART 0
@@ -65,4 +130,15 @@ typedef uint32_t board_id_t;
 
 #define CONFIGFILE_HWMON_TASK_AUTO 0x0040
 
+#define CONFIGFILE_SWMATRIX_GEOMETRY 0x0060
+
+// 5 pages
+#define CONFIGFILE_SWSETTLE 0x0080
+
+// 3 pages
+#define CONFIGFILE_SWMAP 0x0120
+
+// 52 pages up to the end of EEPROM
+#define CONFIGFILE_SWCOUNTER 0x0180
+
 #endif // !_APP_CFG_H__
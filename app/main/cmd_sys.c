@@ -13,8 +13,13 @@
 #include "clksys_getfreq.h"
 #include "cmdarg.h"
 #include "debug.h"
+#include "envmon.h"
+#include "sequencer.h"
+#include "serial.h"
 #include "sp_driver.h"
 #include "stack_usage.h"
+#include "swmatrix_task.h"
+#include "telemetry.h"
 #include "sys_info.h"
 #include "system_driver.h"
 #include "ucos_ii.h"
@@ -85,13 +90,31 @@ static result_t showUptime(void *pOut) {
 }
 
 static result_t showDiag(void *pOut) {
-  return CLI_TPRINTF("Peak stack usage:\n"
+  CLI_TPRINTF_ASSERT("Peak stack usage:\n"
                      "Main  : %4u/%4u\n"
-                     "UI    : %4u/%4u\n",
+                     "UI    : %4u/%4u\n"
+                     "Seq   : %4u/%4u\n"
+                     "Matrix: %4u/%4u\n"
+                     "Env   : %4u/%4u\n"
+                     "Telem : %4u/%4u\n",
                      MAIN_TASK_STACK_SIZE - StackUsage_Peak(mainTaskStack),
                      MAIN_TASK_STACK_SIZE,
                      UI_TASK_STACK_SIZE - StackUsage_Peak(UITask_stack),
-                     UI_TASK_STACK_SIZE);
+                     UI_TASK_STACK_SIZE,
+                     SEQUENCER_TASK_STACK_SIZE -
+                         StackUsage_Peak(SequencerTask_stack),
+                     SEQUENCER_TASK_STACK_SIZE,
+                     SWMATRIX_TASK_STACK_SIZE -
+                         StackUsage_Peak(SwmatrixTask_stack),
+                     SWMATRIX_TASK_STACK_SIZE,
+                     ENVMON_TASK_STACK_SIZE -
+                         StackUsage_Peak(EnvmonTask_stack),
+                     ENVMON_TASK_STACK_SIZE,
+                     TELEMETRY_TASK_STACK_SIZE -
+                         StackUsage_Peak(TelemetryTask_stack),
+                     TELEMETRY_TASK_STACK_SIZE);
+  return CLI_TPRINTF("Console RX overruns: %u\n",
+                     Serial_GetRxOverruns(CONSOLE_USART));
 }
 
 DEFINE_COMMAND(ROOT_SYS, UPTIME, NULL, pObj, args, pOut) {
@@ -6,7 +6,23 @@ APP_COBJS-y += $(BUILDDIR)/app/main/cli.o
 APP_COBJS-y += $(BUILDDIR)/app/main/sys_info.o
 APP_COBJS-y += $(BUILDDIR)/app/main/cmd_sys.o
 APP_COBJS-y += $(BUILDDIR)/app/main/swmatrix.o
+APP_COBJS-y += $(BUILDDIR)/app/main/swmatrix_task.o
+APP_COBJS-y += $(BUILDDIR)/app/main/swchain.o
+APP_COBJS-y += $(BUILDDIR)/app/main/swcounter.o
+APP_COBJS-y += $(BUILDDIR)/app/main/swchnmap.o
+APP_COBJS-y += $(BUILDDIR)/app/main/swgeometry.o
+APP_COBJS-y += $(BUILDDIR)/app/main/swmap.o
+APP_COBJS-y += $(BUILDDIR)/app/main/swsched.o
+APP_COBJS-y += $(BUILDDIR)/app/main/swselftest.o
+APP_COBJS-y += $(BUILDDIR)/app/main/swsettle.o
 APP_COBJS-y += $(BUILDDIR)/app/main/ui.o
+APP_COBJS-y += $(BUILDDIR)/app/main/sequencer.o
+APP_COBJS-y += $(BUILDDIR)/app/main/trigger.o
+APP_COBJS-y += $(BUILDDIR)/app/main/trigout.o
+APP_COBJS-y += $(BUILDDIR)/app/main/envmon.o
+APP_COBJS-y += $(BUILDDIR)/app/main/telemetry.o
+APP_COBJS-y += $(BUILDDIR)/app/main/timebase.o
+APP_COBJS-y += $(BUILDDIR)/app/main/interlock.o
 
 DEFINES += -DSYS_INFO_BUILD_REVISION=\""$(shell  git rev-parse HEAD)"\"
 DEFINES += -DSYS_INFO_BUILD_DATE=\""$(shell date)"\"
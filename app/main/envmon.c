@@ -0,0 +1,248 @@
+/**
+ *  \file
+ *
+ *  \brief Temperature and humidity monitor
+ *
+ *  The sensors are used in the no hold master mode: the measurement is
+ *  started with one transaction and the result is polled for, the sensor
+ *  doesn't acknowledge its address until the conversion is done. The task
+ *  sleeps in between. The I2C engine stays locked for the whole
+ *  measurement, so a command reading a sensor at the same time doesn't
+ *  interleave with it.
+ *
+ *  Every ENVMON_HISTORY_EVERY periods the readings are also appended to the
+ *  history, which the HISTORY commands print in one go.
+ */
+
+#include "envmon.h"
+#include "TWI_master.h"
+#include "astring.h"
+#include "cli.h"
+#include "cmdarg.h"
+#include "mt.h"
+#include <avr/interrupt.h>
+#include <string.h>
+
+OS_STK EnvmonTask_stack[ENVMON_TASK_STACK_SIZE];
+
+#define SI70XX_ADDR 0x40
+#define SI70XX_MEASURE_RH_NO_HOLD 0xf5
+#define SI70XX_MEASURE_T_NO_HOLD 0xf3
+
+// a humidity conversion takes up to 23 ms (including temperature)
+#define ENVMON_POLL_TICKS 1
+#define ENVMON_MAX_POLLS 10
+
+// divides first, any age up to ENVMON_ANY_AGE fits
+#define ENVMON_MS_TO_TICKS(_ms) ((_ms) / (1000 / OS_TICKS_PER_SEC))
+
+typedef struct {
+  uint16_t raw;
+  uint32_t time; // OS ticks
+  bool valid;
+} envmon_value_t;
+
+static twi_iface_t ifaces[2] = {
+    {0x80, 0x40}, // matrix
+    {0x08, 0x04}  // probe card
+};
+
+static const uint8_t commands[2] = {SI70XX_MEASURE_T_NO_HOLD,
+                                    SI70XX_MEASURE_RH_NO_HOLD};
+
+static envmon_value_t cache[2][2];
+
+// [sample][sensor][quantity], the oldest sample at historyHead
+static uint16_t history[ENVMON_HISTORY_SIZE][2][2];
+static uint8_t historyHead;
+static uint8_t historyCount;
+static uint32_t historyTime; // OS ticks of the newest sample
+
+// CRC-8 of the sensor, x^8 + x^5 + x^4 + 1, initialized with 0
+static uint8_t envmon_crc8(const uint8_t *data, uint8_t len) {
+  uint8_t crc = 0;
+  while (len--) {
+    crc ^= *data++;
+    for (uint8_t bit = 0; bit < 8; bit++)
+      crc = crc & 0x80 ? crc << 1 ^ 0x31 : crc << 1;
+  }
+  return crc;
+}
+
+static result_t envmon_measure(twi_iface_t *iface, uint8_t cmd,
+                               uint16_t *pRaw) {
+  uint8_t data[3];
+  twi_trans_t trans = {iface, SI70XX_ADDR, &cmd, 1, NULL, 0, 0};
+  result_t ret = RESULT_OK;
+  twi_lock();
+  twi_submit(&trans);
+  if (twi_wait(&trans) != TWI_OK) {
+    ret = S("Sensor not responding");
+  } else {
+    trans.wrLen = 0;
+    trans.rdData = data;
+    trans.rdLen = sizeof(data);
+    for (uint8_t i = 0;; i++) {
+      OSTimeDly(ENVMON_POLL_TICKS);
+      twi_submit(&trans);
+      twi_status_t status = twi_wait(&trans);
+      if (status == TWI_OK)
+        break;
+      // still converting
+      if (status != TWI_NACK || i >= ENVMON_MAX_POLLS) {
+        ret = S("Sensor timeout");
+        break;
+      }
+    }
+  }
+  twi_unlock();
+  if (ret != RESULT_OK)
+    return ret;
+  if (envmon_crc8(data, 2) != data[2])
+    return S("Sensor CRC error");
+  *pRaw = (uint16_t)data[0] << 8 | data[1];
+  return RESULT_OK;
+}
+
+static result_t envmon_refresh(envmon_sensor_t sensor,
+                               envmon_quantity_t quantity, uint16_t *pRaw) {
+  uint16_t raw;
+  result_t ret = envmon_measure(&ifaces[sensor], commands[quantity], &raw);
+  if (ret != RESULT_OK)
+    return ret;
+  envmon_value_t *pValue = &cache[sensor][quantity];
+  MT_ATOMIC_EXPR(
+      (pValue->raw = raw, pValue->time = OSTimeGet(), pValue->valid = true));
+  if (pRaw)
+    *pRaw = raw;
+  return RESULT_OK;
+}
+
+static void envmon_history_add(uint16_t sample[2][2]) {
+  uint16_t(*pDest)[2];
+  uint8_t sreg = SREG;
+  cli();
+  if (historyCount < ENVMON_HISTORY_SIZE) {
+    pDest = history[(historyHead + historyCount++) % ENVMON_HISTORY_SIZE];
+  } else {
+    // overwrite the oldest
+    pDest = history[historyHead];
+    historyHead = (historyHead + 1) % ENVMON_HISTORY_SIZE;
+  }
+  memcpy(pDest, sample, sizeof(history[0]));
+  historyTime = OSTimeGet();
+  SREG = sreg;
+}
+
+bool envmon_history_get(envmon_sensor_t sensor, uint16_t index,
+                        uint16_t raw[2]) {
+  uint8_t sreg = SREG;
+  cli();
+  bool found = index < historyCount;
+  if (found)
+    memcpy(raw, history[(historyHead + index) % ENVMON_HISTORY_SIZE][sensor],
+           sizeof(history[0][0]));
+  SREG = sreg;
+  return found;
+}
+
+// T = 175.72 * code / 65536 - 46.85 and RH = 125 * code / 65536 - 6, the
+// scale factors reduce to n / 8192 exactly in thousandths
+int32_t envmon_to_milli(envmon_quantity_t quantity, uint16_t raw) {
+  if (quantity == ENVMON_TEMPERATURE)
+    return (int32_t)(((uint32_t)raw * 21965 + 4096) >> 13) - 46850;
+  return (int32_t)(((uint32_t)raw * 15625 + 4096) >> 13) - 6000;
+}
+
+bool envmon_peek(envmon_sensor_t sensor, envmon_quantity_t quantity,
+                 uint16_t *pRaw) {
+  envmon_value_t value;
+  MT_ATOMIC_EXPR(value = cache[sensor][quantity]);
+  *pRaw = value.raw;
+  return value.valid;
+}
+
+result_t envmon_get(envmon_sensor_t sensor, envmon_quantity_t quantity,
+                    uint32_t maxAgeMs, uint16_t *pRaw) {
+  envmon_value_t value;
+  MT_ATOMIC_EXPR(value = cache[sensor][quantity]);
+  if (value.valid && (maxAgeMs == ENVMON_ANY_AGE ||
+                      OSTimeGet() - value.time <= ENVMON_MS_TO_TICKS(maxAgeMs))) {
+    *pRaw = value.raw;
+    return RESULT_OK;
+  }
+  return envmon_refresh(sensor, quantity, pRaw);
+}
+
+void EnvmonTask(void *pArg) {
+  (void)pArg;
+  uint8_t periods = 0;
+  for (;;) {
+    uint16_t sample[2][2];
+    // a failed reading keeps the previous one, which ages
+    for (uint8_t sensor = 0; sensor < 2; sensor++)
+      for (uint8_t quantity = 0; quantity < 2; quantity++)
+        if (envmon_refresh(sensor, quantity, &sample[sensor][quantity]) !=
+            RESULT_OK)
+          sample[sensor][quantity] = ENVMON_HISTORY_INVALID;
+    if (++periods >= ENVMON_HISTORY_EVERY) {
+      periods = 0;
+      envmon_history_add(sample);
+    }
+    OSTimeDlyHMSM(0, 0, ENVMON_PERIOD_S, 0);
+  }
+}
+
+//******************************************************************************
+// user interface
+//******************************************************************************
+
+// Header line, then the samples from the oldest one. The text form has a line
+// per sample, HEX prints the raw codes on one line, 8 digits per sample.
+static result_t envmon_print_history(envmon_sensor_t sensor, const char *args,
+                                     void *pOut) {
+  args = skipSpaces(args);
+  bool hex = false;
+  if (stricmp_P(args, S("HEX")) == 0)
+    hex = true;
+  else if (strlen(args) != 0 && strcmp_P(args, S("?")) != 0)
+    return S("Expected HEX or nothing");
+  uint16_t count;
+  uint32_t time;
+  MT_ATOMIC_EXPR((count = historyCount, time = historyTime));
+  CLI_TPRINTF_ASSERT("PERIOD %u AGE %lu COUNT %u",
+                     ENVMON_PERIOD_S * ENVMON_HISTORY_EVERY,
+                     count ? (OSTimeGet() - time) / OS_TICKS_PER_SEC : 0,
+                     count);
+  if (hex && count)
+    CLI_TPRINTF_ASSERT("\n");
+  // samples added meanwhile shift the oldest ones out
+  for (uint16_t i = 0; i < count; i++) {
+    uint16_t raw[2];
+    if (!envmon_history_get(sensor, i, raw))
+      break;
+    if (hex) {
+      CLI_TPRINTF_ASSERT("%04x%04x", raw[0], raw[1]);
+      continue;
+    }
+    for (uint8_t quantity = 0; quantity < 2; quantity++) {
+      if (quantity)
+        CLI_TPRINTF_ASSERT(" ");
+      else
+        CLI_TPRINTF_ASSERT("\n");
+      if (raw[quantity] == ENVMON_HISTORY_INVALID)
+        CLI_TPRINTF_ASSERT("-");
+      else
+        CLI_TPRINTF_ASSERT("%.3lk", envmon_to_milli(quantity, raw[quantity]));
+    }
+  }
+  return RESULT_OK;
+}
+
+DEFINE_COMMAND(ROOT_MATRIX, HISTORY, NULL, pObj, args, pOut) {
+  return envmon_print_history(ENVMON_MATRIX, args, pOut);
+}
+
+DEFINE_COMMAND(ROOT_PROBECARD, HISTORY, NULL, pObj, args, pOut) {
+  return envmon_print_history(ENVMON_PROBECARD, args, pOut);
+}
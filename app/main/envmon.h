@@ -0,0 +1,91 @@
+/**
+ *  \file
+ *
+ *  \brief Temperature and humidity monitor header file.
+ *
+ *  The monitor task reads the Si70xx sensors on the matrix and the probe
+ *  card every ENVMON_PERIOD_S and keeps the last good readings with the
+ *  time they were taken, so the commands don't wait for a conversion.
+ */
+
+#ifndef _ENVMON_H__
+#define _ENVMON_H__
+
+#include "app_cfg.h"
+#include "types.h"
+#include "ucos_ii.h"
+
+#ifndef ENVMON_TASK_STACK_SIZE
+#error "ENVMON_TASK_STACK_SIZE not defined"
+#endif
+
+#ifndef ENVMON_PERIOD_S
+#error "ENVMON_PERIOD_S not defined"
+#endif
+
+#ifndef ENVMON_HISTORY_SIZE
+#error "ENVMON_HISTORY_SIZE not defined"
+#endif
+
+#if ENVMON_HISTORY_SIZE > 255
+#error "ENVMON_HISTORY_SIZE too large"
+#endif
+
+/// Any cached reading is good enough.
+#define ENVMON_ANY_AGE 0xffffffffUL
+
+/// History entry of a failed reading.
+#define ENVMON_HISTORY_INVALID 0xffff
+
+typedef enum {
+  ENVMON_MATRIX = 0,
+  ENVMON_PROBECARD = 1
+} envmon_sensor_t;
+
+typedef enum {
+  ENVMON_TEMPERATURE = 0,
+  ENVMON_HUMIDITY = 1
+} envmon_quantity_t;
+
+extern OS_STK EnvmonTask_stack[ENVMON_TASK_STACK_SIZE];
+
+/**
+ * \brief Monitor task entry point.
+ */
+void EnvmonTask(void *pArg) __attribute__((noreturn));
+
+/** \brief Get a sensor reading.
+ *
+ *  The sensor is read by the caller if the cached reading is older than
+ *  \p maxAgeMs or there is none.
+ *
+ *  \param[out] pRaw  16 bit code as read from the sensor.
+ */
+result_t envmon_get(envmon_sensor_t sensor, envmon_quantity_t quantity,
+                    uint32_t maxAgeMs, uint16_t *pRaw);
+
+/** \brief Get the cached reading without reading the sensor.
+ *
+ *  \return false if there is no reading yet.
+ */
+bool envmon_peek(envmon_sensor_t sensor, envmon_quantity_t quantity,
+                 uint16_t *pRaw);
+
+/** \brief Convert a sensor code to thousandths of deg C or % RH.
+ *
+ *  Integer form of the Si70xx formulas, rounded to the nearest unit.
+ */
+int32_t envmon_to_milli(envmon_quantity_t quantity, uint16_t raw);
+
+/** \brief Copy a sample of the history.
+ *
+ *  \param[in]  index  0 for the oldest sample.
+ *  \param[out] raw    Temperature and humidity codes, ENVMON_HISTORY_INVALID
+ *                     for a failed reading.
+ *
+ *  \return false if there is no such sample.
+ */
+bool envmon_history_get(envmon_sensor_t sensor, uint16_t index,
+                        uint16_t raw[2]);
+
+#endif // !_ENVMON_H__
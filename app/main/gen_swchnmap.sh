@@ -0,0 +1,40 @@
+#!/bin/bash
+
+# Generates the channel lookup table of the switching matrix.
+#
+# Usage: app/main/gen_swchnmap.sh >app/main/swchnmap.c
+
+CHANNELS=512
+
+# multiplexer address bits A6-A8 and A0-A2 are permuted on the board
+A6A7A8_MAP=(4 5 6 7 3 2 1 0)
+A0A1A2_MAP=(3 2 1 0 4 5 6 7)
+# position of the channel switch inside ADG714
+CHIP_MAP=(3 2 1 0 7 6 5 4)
+
+echo "/**"
+echo " *  \\file"
+echo " *"
+echo " *  \\brief Switching matrix channel lookup table."
+echo " *"
+echo " *  Generated by gen_swchnmap.sh, do not edit."
+echo " */"
+echo ""
+echo "#include \"swchnmap.h\""
+echo ""
+echo "const swchnmap_entry_t swchnmap[SWCHNMAP_CHANNELS] IMMUTABLE_MEM = {"
+
+for ((chn = 0; chn < CHANNELS; chn++)); do
+	addr=$(( (chn & 0x038) |
+		(${A6A7A8_MAP[(chn >> 6) & 0x7]} << 6) |
+		${A0A1A2_MAP[chn & 0x7]} ))
+	row=$(( (chn / 64) % 8 ))
+	chip=$(( (chn / 8) % 8 ))
+	# rows are shifted out starting from the last one
+	byte=$(( (7 - row) * 8 + chip ))
+	mask=$(( 1 << (7 - ${CHIP_MAP[chn % 8]}) ))
+	printf "    {0x%02X, 0x%02X, %2d, 0x%02X}, // %d\n" \
+		$((addr & 0xff)) $((addr >> 8)) $byte $mask $chn
+done
+
+echo "};"
@@ -0,0 +1,94 @@
+/**
+ *  \file
+ *
+ *  \brief Hardware interlock input
+ *
+ *  The input is pulled up and the interlock loop holds it low, so a broken
+ *  loop or a missing connector reads as asserted. The rising edge shorts
+ *  all channels directly from the interrupt, so the reaction time doesn't
+ *  depend on what the tasks are doing.
+ */
+
+#include "interlock.h"
+#include "astring.h"
+#include "cli.h"
+#include "cmdarg.h"
+#include "mt.h"
+#include "swchain.h"
+#include "swmatrix.h"
+#include "timebase.h"
+#include <avr/interrupt.h>
+
+static volatile bool tripped;
+static volatile uint16_t trips;
+
+static void interlock_trip(void) {
+  swchain_inhibit(true);
+  tripped = true;
+  trips++;
+}
+
+MT_ISR(INTERLOCK_IN_vect) {
+  uint32_t now = timebase_now();
+  // no task may latch a frame once the chain is shorted
+  interlock_trip();
+  swmatrix_short_all_fast(now);
+}
+
+void interlock_init(void) {
+  INTERLOCK_IN_PORT.DIRCLR = INTERLOCK_IN_bm;
+  INTERLOCK_IN_PORT.INTERLOCK_IN_PINCTRL =
+      PORT_OPC_PULLUP_gc | PORT_ISC_RISING_gc;
+  INTERLOCK_IN_PORT.INT0MASK = INTERLOCK_IN_bm;
+  INTERLOCK_IN_PORT.INTCTRL =
+      (INTERLOCK_IN_PORT.INTCTRL & ~PORT_INT0LVL_gm) | PORT_INT0LVL_HI_gc;
+  // no edge if the input was asserted before power up
+  if (interlock_is_asserted() && !tripped)
+    MT_ATOMIC_EXPR(interlock_trip());
+}
+
+bool interlock_is_tripped(void) { return tripped; }
+
+bool interlock_is_asserted(void) {
+  return (INTERLOCK_IN_PORT.IN & INTERLOCK_IN_bm) != 0;
+}
+
+result_t interlock_clear(void) {
+  result_t ret = RESULT_OK;
+  // an edge between the check and the clear must not get lost
+  uint8_t sreg = SREG;
+  cli();
+  if (interlock_is_asserted())
+    ret = S("Interlock input is asserted");
+  else {
+    tripped = false;
+    swchain_inhibit(false);
+  }
+  SREG = sreg;
+  return ret;
+}
+
+uint16_t interlock_get_trips(void) {
+  uint16_t n;
+  MT_ATOMIC_EXPR(n = trips);
+  return n;
+}
+
+//******************************************************************************
+// user interface
+//******************************************************************************
+
+DEFINE_COMMAND(ROOT_MATRIX, INTERLOCK, NULL, pObj, args, pOut) {
+  args = skipSpaces(args);
+  // get request
+  if (strlen(args) == 0 || strcmp_P(args, S("?")) == 0)
+    return CLI_TPRINTF("%S INPUT %S TRIPS %u",
+                       interlock_is_tripped() ? S("TRIPPED") : S("OK"),
+                       interlock_is_asserted() ? S("ASSERTED") : S("CLEAR"),
+                       interlock_get_trips());
+  // clear request
+  else if (stricmp_P(args, S("CLEAR")) == 0)
+    return interlock_clear();
+  else
+    return S("Expected CLEAR or nothing");
+}
@@ -0,0 +1,38 @@
+/**
+ *  \file
+ *
+ *  \brief Hardware interlock input header file.
+ *
+ *  An asserted interlock input shorts all channels from the pin change
+ *  interrupt and trips the interlock. While tripped, no channel can be
+ *  selected until the interlock is cleared with the input deasserted.
+ */
+
+#ifndef _INTERLOCK_H__
+#define _INTERLOCK_H__
+
+#include "app_cfg.h"
+#include "types.h"
+
+/** \brief Setup the interlock input and its interrupt.
+ *
+ *  Trips the interlock if the input is already asserted.
+ */
+void interlock_init(void);
+
+/// Returns true if the interlock tripped and was not cleared yet.
+bool interlock_is_tripped(void);
+
+/// Returns true if the interlock input is asserted right now.
+bool interlock_is_asserted(void);
+
+/** \brief Clear the tripped interlock.
+ *
+ *  Fails if the interlock input is still asserted.
+ */
+result_t interlock_clear(void);
+
+/// Number of trips since reset.
+uint16_t interlock_get_trips(void);
+
+#endif // !_INTERLOCK_H__
@@ -9,12 +9,16 @@
 #include "board.h"
 #include "cli.h"
 #include "debug.h"
+#include "envmon.h"
 #include "fifo.h"
 #include "led.h"
+#include "sequencer.h"
 #include "serialstream.h"
 #include "sp_driver.h"
 #include "stack_usage.h"
 #include "swmatrix.h"
+#include "swmatrix_task.h"
+#include "telemetry.h"
 #include "ucos_bsp.h"
 #include "ucos_ii.h"
 #include "ui.h"
@@ -48,12 +52,35 @@ static void mainTask(void *pArg) {
   ByteFifo_Init(&consoleInFifo, consoleInBuffer, CONSOLE_FIFO_SIZE);
   static Stream consoleStream;
   Serial_Init(CONSOLE_USART, CONSOLE_USART_BAUDRATE, &consoleInFifo, NULL,
-              SERIAL_USE_TX_DMA);
+              SERIAL_USE_TX_DMA | SERIAL_USE_RX_DMA);
   SerialStream_Init(&consoleStream, CONSOLE_USART, STREAM_MODE_TEXT);
 
+  DPRINTF("Starting telemetry task ... ");
+  StackUsage_Fill(TelemetryTask_stack, TELEMETRY_TASK_STACK_SIZE);
+  OSTaskCreate(&TelemetryTask, &consoleStream,
+               &TelemetryTask_stack[TELEMETRY_TASK_STACK_SIZE - 1],
+               TELEMETRY_TASK_PRIO);
+
   DPRINTF("Starting UI task ... ");
   OSTaskCreate(&UiTask, 0, &UITask_stack[UI_TASK_STACK_SIZE - 1], UI_TASK_PRIO);
 
+  DPRINTF("Starting sequencer task ... ");
+  StackUsage_Fill(SequencerTask_stack, SEQUENCER_TASK_STACK_SIZE);
+  OSTaskCreate(&SequencerTask, 0,
+               &SequencerTask_stack[SEQUENCER_TASK_STACK_SIZE - 1],
+               SEQUENCER_TASK_PRIO);
+
+  DPRINTF("Starting matrix task ... ");
+  StackUsage_Fill(SwmatrixTask_stack, SWMATRIX_TASK_STACK_SIZE);
+  OSTaskCreate(&SwmatrixTask, 0,
+               &SwmatrixTask_stack[SWMATRIX_TASK_STACK_SIZE - 1],
+               SWMATRIX_TASK_PRIO);
+
+  DPRINTF("Starting environment monitor task ... ");
+  StackUsage_Fill(EnvmonTask_stack, ENVMON_TASK_STACK_SIZE);
+  OSTaskCreate(&EnvmonTask, 0, &EnvmonTask_stack[ENVMON_TASK_STACK_SIZE - 1],
+               ENVMON_TASK_PRIO);
+
   // open serial port and initialize stream for CLI
   // then start CLI task
   DPRINTF("Starting CLI... ");
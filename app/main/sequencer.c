@@ -0,0 +1,232 @@
+/**
+ *  \file
+ *
+ *  \brief Channel scan sequencer
+ *
+ *  Commands only post a request to the sequencer task, which runs at
+ *  a higher priority than the CLI and applies the request immediately.
+ *  Dwell times are counted from the moment the previous step was due,
+ *  not from the moment it was done, so switching time doesn't accumulate.
+ *  The channel of the next step is preloaded into the switch chain during
+ *  the dwell, so a step costs a latch pulse instead of a chain shift.
+ */
+
+#include "sequencer.h"
+#include "astring.h"
+#include "cli.h"
+#include "cmdarg.h"
+#include "debug.h"
+#include "interlock.h"
+#include "mt.h"
+#include "swgeometry.h"
+#include "swmatrix.h"
+#include "swsettle.h"
+#include "ui.h"
+
+OS_STK SequencerTask_stack[SEQUENCER_TASK_STACK_SIZE];
+
+typedef enum {
+  SEQUENCER_REQ_NONE = 0,
+  SEQUENCER_REQ_START,
+  SEQUENCER_REQ_STOP,
+  SEQUENCER_REQ_PAUSE,
+  SEQUENCER_REQ_RESUME,
+  SEQUENCER_REQ_STEP
+} sequencer_req_t;
+
+static sequencer_step_t steps[SEQUENCER_MAX_STEPS];
+static uint8_t stepCount;
+static uint8_t current; // index of the next step
+static volatile sequencer_state_t state;
+static volatile sequencer_req_t request;
+static INT32U deadline;
+static MT_SemType wakeSem;
+
+static IMMUTABLE_STR(idle) = "IDLE";
+static IMMUTABLE_STR(running) = "RUNNING";
+static IMMUTABLE_STR(paused) = "PAUSED";
+
+static void sequencer_do_step(void) {
+  if (state == SEQUENCER_IDLE)
+    return;
+  if (current >= stepCount) {
+    state = SEQUENCER_IDLE;
+    return;
+  }
+  sequencer_step_t *pStep = &steps[current];
+  swmatrix_set_meas(pStep->meas);
+  swmatrix_set_cvres(pStep->cvres);
+  uint16_t chn;
+  if (swmatrix_get_preloaded() == pStep->chn &&
+      swmatrix_commit(&chn) == RESULT_OK && chn == pStep->chn)
+    ui_show_value(chn);
+  else
+    ui_set_value(pStep->chn);
+  // the dwell is the measurement time, the channel has to settle first
+  deadline += swsettle_get_ticks(pStep->chn) + pStep->dwell;
+  current++;
+  // shift the next channel in during the dwell
+  if (current < stepCount)
+    swmatrix_preload(steps[current].chn);
+}
+
+static void sequencer_handle_request(void) {
+  sequencer_req_t req = request;
+  request = SEQUENCER_REQ_NONE;
+  switch (req) {
+  case SEQUENCER_REQ_START:
+    current = 0;
+    deadline = OSTimeGet();
+    state = stepCount ? SEQUENCER_RUNNING : SEQUENCER_IDLE;
+    break;
+  case SEQUENCER_REQ_STOP:
+    state = SEQUENCER_IDLE;
+    break;
+  case SEQUENCER_REQ_PAUSE:
+    if (state == SEQUENCER_RUNNING)
+      state = SEQUENCER_PAUSED;
+    break;
+  case SEQUENCER_REQ_RESUME:
+    if (state == SEQUENCER_PAUSED) {
+      deadline = OSTimeGet();
+      state = SEQUENCER_RUNNING;
+    }
+    break;
+  case SEQUENCER_REQ_STEP:
+    if (state != SEQUENCER_RUNNING) {
+      if (state == SEQUENCER_IDLE)
+        current = 0;
+      state = SEQUENCER_PAUSED;
+      sequencer_do_step();
+    }
+    break;
+  default:
+    break;
+  }
+}
+
+void SequencerTask(void *pArg) {
+  (void)pArg;
+  if (!MT_SEM_INIT(wakeSem, 0)) {
+    DPRINTF("Sequencer: Can't create semaphore\n");
+    for (;;)
+      OSTimeDlyHMSM(1, 0, 0, 0);
+  }
+  for (;;) {
+    if (request != SEQUENCER_REQ_NONE)
+      sequencer_handle_request();
+    INT16U timeout = 0; // wait for a request
+    if (state == SEQUENCER_RUNNING) {
+      INT32S remaining = (INT32S)(deadline - OSTimeGet());
+      if (remaining <= 0) {
+        sequencer_do_step();
+        continue;
+      }
+      timeout = remaining;
+    }
+    MT_SEM_PEND(wakeSem, timeout);
+  }
+}
+
+void sequencer_abort(void) {
+  request = SEQUENCER_REQ_NONE;
+  state = SEQUENCER_IDLE;
+}
+
+static result_t sequencer_request(sequencer_req_t req) {
+  if (!wakeSem)
+    return S("Sequencer not running");
+  request = req;
+  MT_SEM_POST(wakeSem);
+  return RESULT_OK;
+}
+
+//******************************************************************************
+// user interface
+//******************************************************************************
+
+DEFINE_COMMAND(ROOT_MATRIX_SEQUENCE, ADD, NULL, pObj, args, pOut) {
+  if (state != SEQUENCER_IDLE)
+    return S("Sequencer is busy");
+  if (stepCount >= SEQUENCER_MAX_STEPS)
+    return S("Sequence is full");
+
+  int32_t chn, dwell;
+  swmatrix_meas_t meas;
+  swmatrix_cvres_t cvres;
+  result_t ret = parseInt(&args, 0, swgeometry_channels() - 1, &chn);
+  if (ret != RESULT_OK)
+    return ret;
+  ret = swmatrix_parse_meas(&args, &meas);
+  if (ret != RESULT_OK)
+    return ret;
+  ret = swmatrix_parse_cvres(&args, &cvres);
+  if (ret != RESULT_OK)
+    return ret;
+  ret = parseInt(&args, 1, 600000, &dwell);
+  if (ret != RESULT_OK)
+    return ret;
+  if (*skipSpaces(args))
+    return S("Expected nothing after the dwell");
+
+  // round dwell up to full ticks
+  sequencer_step_t *pStep = &steps[stepCount];
+  pStep->chn = chn;
+  pStep->meas = meas;
+  pStep->cvres = cvres;
+  pStep->dwell = (dwell * OS_TICKS_PER_SEC + 999) / 1000;
+  stepCount++;
+  return RESULT_OK;
+}
+
+DEFINE_COMMAND(ROOT_MATRIX_SEQUENCE, CLEAR, NULL, pObj, args, pOut) {
+  if (state != SEQUENCER_IDLE)
+    return S("Sequencer is busy");
+  stepCount = 0;
+  current = 0;
+  return RESULT_OK;
+}
+
+DEFINE_COMMAND(ROOT_MATRIX_SEQUENCE, LIST, NULL, pObj, args, pOut) {
+  for (uint8_t i = 0; i < stepCount; i++) {
+    sequencer_step_t *pStep = &steps[i];
+    CLI_TPRINTF_ASSERT("%3u: %3u %S %4S %lu\n", i, pStep->chn,
+                       swmatrix_meas_name(pStep->meas),
+                       swmatrix_cvres_name(pStep->cvres),
+                       (uint32_t)pStep->dwell * 1000 / OS_TICKS_PER_SEC);
+  }
+  return RESULT_OK;
+}
+
+DEFINE_COMMAND(ROOT_MATRIX_SEQUENCE, START, NULL, pObj, args, pOut) {
+  if (interlock_is_tripped())
+    return S("Interlock tripped");
+  return sequencer_request(SEQUENCER_REQ_START);
+}
+
+DEFINE_COMMAND(ROOT_MATRIX_SEQUENCE, STOP, NULL, pObj, args, pOut) {
+  return sequencer_request(SEQUENCER_REQ_STOP);
+}
+
+DEFINE_COMMAND(ROOT_MATRIX_SEQUENCE, PAUSE, NULL, pObj, args, pOut) {
+  return sequencer_request(SEQUENCER_REQ_PAUSE);
+}
+
+DEFINE_COMMAND(ROOT_MATRIX_SEQUENCE, RESUME, NULL, pObj, args, pOut) {
+  return sequencer_request(SEQUENCER_REQ_RESUME);
+}
+
+DEFINE_COMMAND(ROOT_MATRIX_SEQUENCE, STEP, NULL, pObj, args, pOut) {
+  return sequencer_request(SEQUENCER_REQ_STEP);
+}
+
+DEFINE_COMMAND(ROOT_MATRIX_SEQUENCE, STATUS, NULL, pObj, args, pOut) {
+  immutable_str name = idle;
+  if (state == SEQUENCER_RUNNING)
+    name = running;
+  else if (state == SEQUENCER_PAUSED)
+    name = paused;
+  return CLI_TPRINTF("%S %u/%u", name, current, stepCount);
+}
+
+DEFINE_COMMAND_ARRAY(ROOT_MATRIX, SEQUENCE, STATUS);
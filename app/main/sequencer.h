@@ -0,0 +1,51 @@
+/**
+ *  \file
+ *
+ *  \brief Channel scan sequencer header file.
+ *
+ *  The sequencer steps through a table of channels uploaded with
+ *  MATRIX.SEQUENCE commands. Every step selects a channel, measurement type
+ *  and CV resistor and holds them for the given dwell time.
+ */
+
+#ifndef _SEQUENCER_H__
+#define _SEQUENCER_H__
+
+#include "types.h"
+#include "ucos_ii.h"
+
+#ifndef SEQUENCER_TASK_STACK_SIZE
+#error "SEQUENCER_TASK_STACK_SIZE not defined"
+#endif
+
+#ifndef SEQUENCER_MAX_STEPS
+#error "SEQUENCER_MAX_STEPS not defined"
+#endif
+
+extern OS_STK SequencerTask_stack[SEQUENCER_TASK_STACK_SIZE];
+
+typedef enum {
+  SEQUENCER_IDLE = 0,
+  SEQUENCER_RUNNING = 1,
+  SEQUENCER_PAUSED = 2
+} sequencer_state_t;
+
+typedef struct {
+  uint16_t chn;      // channel or 0xffff for all shorted
+  uint8_t meas : 1;  // swmatrix_meas_t
+  uint8_t cvres : 3; // swmatrix_cvres_t
+  uint16_t dwell;    // in OS ticks
+} sequencer_step_t;
+
+/**
+ * \brief Sequencer task entry point.
+ */
+void SequencerTask(void *pArg) __attribute__((noreturn));
+
+/** \brief Stop the sequence without waiting for the task.
+ *
+ *  \note May be called from an ISR.
+ */
+void sequencer_abort(void);
+
+#endif // !_SEQUENCER_H__
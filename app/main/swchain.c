@@ -0,0 +1,407 @@
+/**
+ *  \file
+ *
+ *  \brief ADG714 switch chain driver
+ *
+ *  Each bit is sent as two PORTD samples: data with clock high, then data
+ *  with clock low. ADG714 captures data on the falling edge of SCLK, so
+ *  data changing together with the rising edge leaves a full sample of
+ *  setup and hold time. The samples are written to PORTD.OUT by a DMA
+ *  channel triggered by TCC1 overflow, one byte per overflow.
+ *
+ *  The waveform keeps the state of the other PORTD pins (A8 of the mux
+ *  address) from the moment it was prepared. If they change before
+ *  the load starts, the waveform is rebased.
+ *
+ *  A shadow of the switch state is kept next to the waveform: the frame
+ *  image is copied to the spare half of the shadow when the load starts and
+ *  the halves are swapped by the latch, so the latch stays a single store
+ *  in the trigger ISR.
+ */
+
+#include "swchain.h"
+#include "TC_driver.h"
+#include "clksys_getfreq.h"
+#include "debug.h"
+#include "dma_alloc.h"
+#include "dma_driver.h"
+#include "mt.h"
+#include "pins.h"
+#include "swcounter.h"
+#include <avr/interrupt.h>
+#include <string.h>
+
+#define SWCHAIN_RESET 0x08 // active high (signal is inverted on the board)
+#define SWCHAIN_SYNC 0x10
+#define SWCHAIN_DIN 0x20 // inverted on the board
+#define SWCHAIN_SCLK 0x80
+#define SWCHAIN_PINS (SWCHAIN_RESET | SWCHAIN_SYNC | SWCHAIN_DIN | SWCHAIN_SCLK)
+
+#define SWCHAIN_WAVE_LENGTH(_chips) ((_chips) * 8 * 2)
+
+// the longest shift takes about half a second
+#define SWCHAIN_TIMEOUT_TICKS OS_TICKS_PER_SEC
+
+// value of waveSingle when the waveform doesn't hold a single byte frame
+#define SWCHAIN_NOT_SINGLE 0xffff
+
+static uint8_t wave[SWCHAIN_WAVE_LENGTH(SWCHAIN_MAX_CHIPS)];
+static uint8_t waveBase;
+static uint16_t waveSingle = SWCHAIN_NOT_SINGLE;
+static volatile DMA_CH_t *pDMA;
+static MT_SemType doneSem;
+static void (*volatile onDone)(void);
+static volatile bool busy;
+static volatile bool loaded; // shifted in, but not latched yet
+static uint16_t chips = SWCHAIN_DEFAULT_CHIPS;
+static uint8_t frameImage[SWCHAIN_MAX_CHIPS]; // frame in the waveform
+static uint8_t image[2][SWCHAIN_MAX_CHIPS];   // latched and loaded frames
+static uint16_t imageSingle[2]; // chip of a single byte frame or NOT_SINGLE
+static volatile uint8_t latchedImage;     // index of the latched frame
+static volatile bool imageReset;          // all shorted by reset since latch
+static volatile bool inhibit;             // set by the interlock
+static uint32_t bitPeriod = SWCHAIN_DEFAULT_BIT_PERIOD_NS;
+static uint16_t timerPeriod;
+
+static void swchain_dma_isr(void *pObj) {
+  (void)pObj;
+  TC1_ConfigClockSource(&TCC1, TC_CLKSEL_OFF_gc);
+  pDMA->CTRLB |= DMA_CH_ERRIF_bm | DMA_CH_TRNIF_bm;
+  busy = false;
+  void (*cb)(void) = onDone;
+  if (cb)
+    cb();
+  else
+    MT_SEM_POST(doneSem);
+}
+
+// Peripheral clocks per sample, two samples per bit
+static uint32_t swchain_sample_clocks(uint32_t ns) {
+  uint32_t mhz = CLKSYS_GetFrequency(CLKSYS_OUTPUT_PER) / 1000000;
+  return ns * mhz / 2000;
+}
+
+static void swchain_update_timer_period(void) {
+  uint32_t clocks = swchain_sample_clocks(bitPeriod);
+  // the clock may have been slowed down since the period was set, run as
+  // fast as it allows
+  timerPeriod = clocks ? (uint16_t)(clocks - 1) : 0;
+}
+
+void swchain_reset(void) {
+  PINS_SET(CHAIN, SWCHAIN_RESET);
+  PINS_SET(CHAIN, SWCHAIN_RESET);
+  PINS_SET(CHAIN, SWCHAIN_RESET);
+  volatile uint8_t i;
+  for (i = 0; i < 10; i++)
+    ;
+  PINS_CLR(CHAIN, SWCHAIN_RESET);
+  loaded = false;
+  imageReset = true;
+}
+
+result_t swchain_init(void) {
+  // sync 0
+  PINS_CLR(CHAIN, SWCHAIN_SYNC);
+
+  swchain_reset();
+  if (!pDMA) {
+    memset(image, 0xff, sizeof(image));
+    imageSingle[0] = imageSingle[1] = SWCHAIN_NOT_SINGLE;
+  }
+
+  // the system clock may have changed since the last call
+  swchain_update_timer_period();
+
+  if (!pDMA) {
+    TC1_Reset(&TCC1);
+    TC1_ConfigWGM(&TCC1, TC_WGMODE_NORMAL_gc);
+    pDMA = DMA_AllocChannel(&swchain_dma_isr, NULL);
+    if (!pDMA)
+      return S("swchain_init: No DMA channels available");
+    DMA_SetIntLevel(pDMA, DMA_CH_TRNINTLVL_HI_gc, DMA_CH_ERRINTLVL_HI_gc);
+  }
+  // semaphores can't be created before the OS is initialized
+  if (OSRunning && !doneSem && !MT_SEM_INIT(doneSem, 0))
+    return S("swchain_init: Can't create semaphore");
+  return RESULT_OK;
+}
+
+result_t swchain_set_bit_period(uint32_t ns) {
+  if (ns < SWCHAIN_MIN_BIT_PERIOD_NS || ns > SWCHAIN_MAX_BIT_PERIOD_NS)
+    return S("swchain: bit period out of range");
+  if (!swchain_sample_clocks(ns))
+    return S("swchain: bit period too short for the clock");
+  bitPeriod = ns;
+  swchain_update_timer_period();
+  return RESULT_OK;
+}
+
+uint32_t swchain_get_bit_period(void) { return bitPeriod; }
+
+result_t swchain_set_chips(uint16_t n) {
+  if (n < 1 || n > SWCHAIN_MAX_CHIPS)
+    return S("swchain: number of chips out of range");
+  if (busy)
+    return S("swchain: transfer in progress");
+  chips = n;
+  // the waveform and the shadow no longer match the chain
+  waveSingle = SWCHAIN_NOT_SINGLE;
+  swchain_reset();
+  memset(image, 0xff, sizeof(image));
+  imageSingle[0] = imageSingle[1] = SWCHAIN_NOT_SINGLE;
+  return RESULT_OK;
+}
+
+uint16_t swchain_get_chips(void) { return chips; }
+
+static void swchain_wave_byte(uint16_t chip, uint8_t b) {
+  uint8_t *p = &wave[chip * 16];
+  for (uint8_t bit = 0; bit < 8; bit++) {
+    // there is an inverter on the board
+    uint8_t s = (b & 0x80) ? waveBase : waveBase | SWCHAIN_DIN;
+    *p++ = s | SWCHAIN_SCLK;
+    *p++ = s;
+    b <<= 1;
+  }
+}
+
+void swchain_prepare(const uint8_t *frame) {
+  waveBase = PORTD.OUT & ~SWCHAIN_PINS;
+  waveSingle = SWCHAIN_NOT_SINGLE;
+  for (uint16_t chip = 0; chip < chips; chip++)
+    swchain_wave_byte(chip, frame[chip]);
+  memcpy(frameImage, frame, chips);
+}
+
+void swchain_prepare_single(uint16_t chip, uint8_t b) {
+  if (waveSingle == SWCHAIN_NOT_SINGLE) {
+    waveBase = PORTD.OUT & ~SWCHAIN_PINS;
+    for (uint16_t c = 0; c < chips; c++)
+      swchain_wave_byte(c, 0xff);
+    memset(frameImage, 0xff, chips);
+  } else {
+    swchain_wave_byte(waveSingle, 0xff);
+    frameImage[waveSingle] = 0xff;
+  }
+  swchain_wave_byte(chip, b);
+  frameImage[chip] = b;
+  waveSingle = chip;
+}
+
+static void swchain_rebase(void) {
+  uint8_t base = PORTD.OUT & ~SWCHAIN_PINS;
+  if (base == waveBase)
+    return;
+  for (uint16_t i = 0; i < SWCHAIN_WAVE_LENGTH(chips); i++)
+    wave[i] = (wave[i] & SWCHAIN_PINS) | base;
+  waveBase = base;
+}
+
+static void swchain_begin_frame(void) {
+  loaded = true;
+  memcpy(image[latchedImage ^ 1], frameImage, chips);
+  imageSingle[latchedImage ^ 1] = waveSingle;
+
+  // clock 1
+  PINS_SET(CHAIN, SWCHAIN_SCLK);
+  PINS_SET(CHAIN, SWCHAIN_SCLK);
+  // sync 1
+  PINS_SET(CHAIN, SWCHAIN_SYNC);
+  // clock 0
+  PINS_CLR(CHAIN, SWCHAIN_SCLK);
+  PINS_CLR(CHAIN, SWCHAIN_SCLK);
+  PINS_CLR(CHAIN, SWCHAIN_SCLK);
+  PINS_CLR(CHAIN, SWCHAIN_SCLK);
+
+  // sync 0
+  PINS_CLR(CHAIN, SWCHAIN_SYNC);
+}
+
+/** \brief Clock the waveform out by software, used when no DMA channel
+ *         is available.
+ */
+static void swchain_load_sw(void) {
+  for (uint16_t i = 0; i < SWCHAIN_WAVE_LENGTH(chips); i++) {
+    PORTD.OUT = wave[i];
+    volatile uint8_t d;
+    for (d = 0; d < 30; d++)
+      ;
+  }
+}
+
+static void swchain_start_dma(void) {
+  TC_SetPeriod(&TCC1, timerPeriod);
+  TC_SetCount(&TCC1, 0);
+  TC_ClearOverflowFlag(&TCC1);
+
+  DMA_SetupBlock(pDMA, wave, DMA_CH_SRCRELOAD_NONE_gc, DMA_CH_SRCDIR_INC_gc,
+                 (void *)&PORTD.OUT, DMA_CH_DESTRELOAD_NONE_gc,
+                 DMA_CH_DESTDIR_FIXED_gc, SWCHAIN_WAVE_LENGTH(chips),
+                 DMA_CH_BURSTLEN_1BYTE_gc, 0, false);
+  DMA_EnableSingleShot(pDMA);
+  DMA_SetTriggerSource(pDMA, DMA_CH_TRIGSRC_TCC1_OVF_gc);
+  busy = true;
+  DMA_EnableChannel(pDMA);
+  TC1_ConfigClockSource(&TCC1, TC_CLKSEL_DIV1_gc);
+}
+
+void swchain_discard(void) {
+  if (loaded)
+    swchain_reset();
+}
+
+bool swchain_pending(void) { return loaded; }
+
+result_t swchain_load(void) {
+  // raising sync would latch the pending frame
+  if (loaded)
+    return S("swchain: frame pending");
+  swchain_rebase();
+  swchain_begin_frame();
+  if (!pDMA) {
+    swchain_load_sw();
+    return RESULT_OK;
+  }
+  onDone = NULL;
+  swchain_start_dma();
+  if (OSRunning && doneSem) {
+    if (!MT_SEM_PEND(doneSem, SWCHAIN_TIMEOUT_TICKS)) {
+      busy = false;
+      swchain_abort();
+      DPRINTF("swchain: DMA timeout\n");
+      return S("swchain: DMA timeout");
+    }
+    // woken by swchain_abort(), the frame is gone
+    if (!loaded)
+      return S("swchain: load aborted");
+  } else {
+    // interrupts are not running yet, poll for completion
+    while (!(pDMA->CTRLB & (DMA_CH_ERRIF_bm | DMA_CH_TRNIF_bm)))
+      ;
+    TC1_ConfigClockSource(&TCC1, TC_CLKSEL_OFF_gc);
+    pDMA->CTRLB |= DMA_CH_ERRIF_bm | DMA_CH_TRNIF_bm;
+    busy = false;
+  }
+  return RESULT_OK;
+}
+
+result_t swchain_load_async(void (*done)(void)) {
+  if (loaded)
+    return S("swchain: frame pending");
+  // the waveform of the transfer in progress would be overwritten
+  if (busy)
+    return S("swchain: busy");
+  swchain_rebase();
+  swchain_begin_frame();
+  if (!pDMA) {
+    swchain_load_sw();
+    if (done)
+      done();
+    return RESULT_OK;
+  }
+  onDone = done;
+  swchain_start_dma();
+  return RESULT_OK;
+}
+
+bool swchain_busy(void) { return busy; }
+
+bool swchain_abort(void) {
+  TC1_ConfigClockSource(&TCC1, TC_CLKSEL_OFF_gc);
+  if (pDMA) {
+    DMA_DisableChannel(pDMA);
+    pDMA->CTRLB |= DMA_CH_ERRIF_bm | DMA_CH_TRNIF_bm;
+  }
+  // the bits shifted in so far must never be latched
+  swchain_reset();
+  bool waiting = busy && !onDone;
+  busy = false;
+  return waiting;
+}
+
+void swchain_wake(void) {
+  if (OSRunning && doneSem)
+    MT_SEM_POST(doneSem);
+}
+
+/// Count the switches shorted by reset, i.e. the open ones of a frame.
+static void swchain_count_opened(uint8_t index) {
+  const uint8_t *p = image[index];
+  uint16_t single = imageSingle[index];
+  if (single != SWCHAIN_NOT_SINGLE) {
+    swcounter_count(single, ~p[single]);
+    return;
+  }
+  for (uint16_t c = 0; c < chips; c++)
+    if (p[c] != 0xff)
+      swcounter_count(c, ~p[c]);
+}
+
+static void swchain_count_toggles(void) {
+  uint8_t old = latchedImage;
+  uint8_t next = old ^ 1;
+  if (imageReset) {
+    swchain_count_opened(old);
+    swchain_count_opened(next);
+    return;
+  }
+  const uint8_t *pOld = image[old];
+  const uint8_t *pNew = image[next];
+  // channel selection changes at most two chips, don't scan the chain
+  if (imageSingle[old] != SWCHAIN_NOT_SINGLE &&
+      imageSingle[next] != SWCHAIN_NOT_SINGLE) {
+    uint16_t c = imageSingle[old];
+    swcounter_count(c, pOld[c] ^ pNew[c]);
+    if (imageSingle[next] != c) {
+      c = imageSingle[next];
+      swcounter_count(c, pOld[c] ^ pNew[c]);
+    }
+    return;
+  }
+  for (uint16_t c = 0; c < chips; c++)
+    if (pOld[c] != pNew[c])
+      swcounter_count(c, pOld[c] ^ pNew[c]);
+}
+
+void swchain_inhibit(bool on) { inhibit = on; }
+
+bool swchain_latch(void) {
+  uint8_t sreg = SREG;
+  // the interlock may trip between the caller's check and the edge
+  cli();
+  if (inhibit) {
+    swchain_discard();
+    SREG = sreg;
+    return false;
+  }
+  // nothing to latch if the frame was discarded by reset or abort
+  bool latched = loaded;
+  if (latched) {
+    // sync 1, outputs are updated on the rising edge
+    PINS_SET(CHAIN, SWCHAIN_SYNC);
+    loaded = false;
+    swchain_count_toggles();
+    latchedImage ^= 1;
+    imageReset = false;
+  }
+  SREG = sreg;
+  return latched;
+}
+
+void swchain_get_image(uint8_t *frame) {
+  uint8_t sreg = SREG;
+  cli();
+  if (imageReset)
+    memset(frame, 0xff, chips);
+  else
+    memcpy(frame, image[latchedImage], chips);
+  SREG = sreg;
+}
+
+void swchain_shift(const uint8_t *frame) {
+  swchain_prepare(frame);
+  swchain_discard();
+  swchain_load();
+  swchain_latch();
+}
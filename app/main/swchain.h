@@ -0,0 +1,169 @@
+/**
+ *  \file
+ *
+ *  \brief ADG714 switch chain driver header file.
+ *
+ *  The daisy chain of ADG714 switches is driven through PORTD:
+ *  reset on PD3, sync on PD4, data on PD5 and clock on PD7.
+ *  Frames are shifted out by DMA from a precomputed PORTD waveform
+ *  paced by a timer, so the calling task sleeps while the bits
+ *  are clocked out.
+ */
+
+#ifndef _SWCHAIN_H__
+#define _SWCHAIN_H__
+
+#include "app_cfg.h"
+#include "types.h"
+
+#ifndef SWCHAIN_MAX_CHIPS
+#error "SWCHAIN_MAX_CHIPS not defined"
+#endif
+
+/// Number of ADG714 chips in the chain after reset.
+#define SWCHAIN_DEFAULT_CHIPS 64
+
+/// Bit period used after reset (in nanoseconds).
+#define SWCHAIN_DEFAULT_BIT_PERIOD_NS 2000
+#define SWCHAIN_MIN_BIT_PERIOD_NS 500
+#define SWCHAIN_MAX_BIT_PERIOD_NS 1000000
+
+/** \brief Setup chain control pins, reset the switches and allocate DMA.
+ *
+ *  \note May be called more than once, e.g. before and after the OS start.
+ */
+result_t swchain_init(void);
+
+/** \brief Pulse the chain reset line.
+ *
+ *  All switches are shorted to ground at once and a loaded but not latched
+ *  frame is discarded.
+ *
+ *  \note May be called from an ISR.
+ */
+void swchain_reset(void);
+
+/** \brief Prepare the waveform of a frame.
+ *
+ *  \param[in]  frame  swchain_get_chips() bytes. frame[0] is shifted out first
+ *                     and thus ends up in the last chip of the chain.
+ *                     Bit set means the switch is shorted to ground.
+ */
+void swchain_prepare(const uint8_t *frame);
+
+/** \brief Prepare the waveform of a frame with all switches shorted
+ *         but the ones cleared in byte \p b of \p chip.
+ *
+ *  Only the bytes changed since the previous call are rewritten,
+ *  so it's cheap enough to be called from an ISR.
+ */
+void swchain_prepare_single(uint16_t chip, uint8_t b);
+
+/** \brief Shift the prepared waveform into the chain without latching it.
+ *
+ *  The switches keep their state until swchain_latch() is called.
+ *  Starting a frame latches the one loaded before, so the load is refused
+ *  while a frame is pending. Use swchain_discard() to drop it.
+ *
+ *  \note Blocks the calling task until the transfer is done.
+ */
+result_t swchain_load(void);
+
+/** \brief Start shifting the prepared waveform and return immediately.
+ *
+ *  Refused while a frame is pending, as swchain_load(), or while another
+ *  transfer is in progress.
+ *
+ *  \param[in]  done  Called from the DMA ISR when the transfer completes.
+ *
+ *  \note May be called from an ISR.
+ */
+result_t swchain_load_async(void (*done)(void));
+
+/// Returns true while a frame is loaded, or being loaded, but not latched.
+bool swchain_pending(void);
+
+/** \brief Drop the pending frame, if any.
+ *
+ *  The only way is swchain_reset(), which shorts all switches. Meant for
+ *  callers about to latch a new frame anyway.
+ *
+ *  \note May be called from an ISR.
+ */
+void swchain_discard(void);
+
+/// Returns true while a transfer is in progress.
+bool swchain_busy(void);
+
+/** \brief Stop the transfer in progress and reset the chain.
+ *
+ *  A task waiting in swchain_load() is not woken up here, so that the
+ *  caller can finish its work with interrupts disabled first.
+ *
+ *  \return true if swchain_wake() has to be called afterwards.
+ *
+ *  \note May be called from a task or an MT_ISR.
+ */
+bool swchain_abort(void);
+
+/** \brief Wake up the task waiting in swchain_load() after swchain_abort().
+ *
+ *  \note Call with interrupts enabled, from a task or an MT_ISR.
+ */
+void swchain_wake(void);
+
+/** \brief Latch the loaded frame (SYNC rising edge).
+ *
+ *  Does nothing if the frame was discarded in the meantime. While inhibited,
+ *  the frame is discarded instead of latched.
+ *
+ *  \return true if the frame was latched.
+ *
+ *  \note May be called from an ISR.
+ */
+bool swchain_latch(void);
+
+/** \brief Refuse to latch any frame, e.g. while the interlock is tripped.
+ *
+ *  \note May be called from an ISR.
+ */
+void swchain_inhibit(bool on);
+
+/** \brief Copy the frame latched in the chain, i.e. the switch state.
+ *
+ *  Answered from a RAM shadow, the chain is not read back.
+ *
+ *  \param[out] frame  swchain_get_chips() bytes, same layout as in
+ *                     swchain_prepare().
+ */
+void swchain_get_image(uint8_t *frame);
+
+/** \brief Shift a frame into the chain and latch it.
+ *
+ *  A pending frame is discarded first.
+ *
+ *  \note Blocks the calling task until the frame is latched.
+ *        Not reentrant, callers have to serialize access to the chain.
+ */
+void swchain_shift(const uint8_t *frame);
+
+/** \brief Set period of the chain clock.
+ *
+ *  \param[in]  ns  Bit period in nanoseconds.
+ */
+result_t swchain_set_bit_period(uint32_t ns);
+
+uint32_t swchain_get_bit_period(void);
+
+/** \brief Set the number of ADG714 chips in the chain, i.e. the number
+ *         of bytes in a frame.
+ *
+ *  The chain is reset, so all switches get shorted.
+ *
+ *  \param[in]  n  1 to SWCHAIN_MAX_CHIPS.
+ */
+result_t swchain_set_chips(uint16_t n);
+
+uint16_t swchain_get_chips(void);
+
+#endif // !_SWCHAIN_H__
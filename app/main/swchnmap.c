@@ -0,0 +1,524 @@
+/**
+ *  \file
+ *
+ *  \brief Switching matrix channel lookup table.
+ *
+ *  Generated by gen_swchnmap.sh, do not edit.
+ */
+
+#include "swchnmap.h"
+
+const swchnmap_entry_t swchnmap[SWCHNMAP_CHANNELS] IMMUTABLE_MEM = {
+    {0x03, 0x01, 56, 0x10}, // 0
+    {0x02, 0x01, 56, 0x20}, // 1
+    {0x01, 0x01, 56, 0x40}, // 2
+    {0x00, 0x01, 56, 0x80}, // 3
+    {0x04, 0x01, 56, 0x01}, // 4
+    {0x05, 0x01, 56, 0x02}, // 5
+    {0x06, 0x01, 56, 0x04}, // 6
+    {0x07, 0x01, 56, 0x08}, // 7
+    {0x0B, 0x01, 57, 0x10}, // 8
+    {0x0A, 0x01, 57, 0x20}, // 9
+    {0x09, 0x01, 57, 0x40}, // 10
+    {0x08, 0x01, 57, 0x80}, // 11
+    {0x0C, 0x01, 57, 0x01}, // 12
+    {0x0D, 0x01, 57, 0x02}, // 13
+    {0x0E, 0x01, 57, 0x04}, // 14
+    {0x0F, 0x01, 57, 0x08}, // 15
+    {0x13, 0x01, 58, 0x10}, // 16
+    {0x12, 0x01, 58, 0x20}, // 17
+    {0x11, 0x01, 58, 0x40}, // 18
+    {0x10, 0x01, 58, 0x80}, // 19
+    {0x14, 0x01, 58, 0x01}, // 20
+    {0x15, 0x01, 58, 0x02}, // 21
+    {0x16, 0x01, 58, 0x04}, // 22
+    {0x17, 0x01, 58, 0x08}, // 23
+    {0x1B, 0x01, 59, 0x10}, // 24
+    {0x1A, 0x01, 59, 0x20}, // 25
+    {0x19, 0x01, 59, 0x40}, // 26
+    {0x18, 0x01, 59, 0x80}, // 27
+    {0x1C, 0x01, 59, 0x01}, // 28
+    {0x1D, 0x01, 59, 0x02}, // 29
+    {0x1E, 0x01, 59, 0x04}, // 30
+    {0x1F, 0x01, 59, 0x08}, // 31
+    {0x23, 0x01, 60, 0x10}, // 32
+    {0x22, 0x01, 60, 0x20}, // 33
+    {0x21, 0x01, 60, 0x40}, // 34
+    {0x20, 0x01, 60, 0x80}, // 35
+    {0x24, 0x01, 60, 0x01}, // 36
+    {0x25, 0x01, 60, 0x02}, // 37
+    {0x26, 0x01, 60, 0x04}, // 38
+    {0x27, 0x01, 60, 0x08}, // 39
+    {0x2B, 0x01, 61, 0x10}, // 40
+    {0x2A, 0x01, 61, 0x20}, // 41
+    {0x29, 0x01, 61, 0x40}, // 42
+    {0x28, 0x01, 61, 0x80}, // 43
+    {0x2C, 0x01, 61, 0x01}, // 44
+    {0x2D, 0x01, 61, 0x02}, // 45
+    {0x2E, 0x01, 61, 0x04}, // 46
+    {0x2F, 0x01, 61, 0x08}, // 47
+    {0x33, 0x01, 62, 0x10}, // 48
+    {0x32, 0x01, 62, 0x20}, // 49
+    {0x31, 0x01, 62, 0x40}, // 50
+    {0x30, 0x01, 62, 0x80}, // 51
+    {0x34, 0x01, 62, 0x01}, // 52
+    {0x35, 0x01, 62, 0x02}, // 53
+    {0x36, 0x01, 62, 0x04}, // 54
+    {0x37, 0x01, 62, 0x08}, // 55
+    {0x3B, 0x01, 63, 0x10}, // 56
+    {0x3A, 0x01, 63, 0x20}, // 57
+    {0x39, 0x01, 63, 0x40}, // 58
+    {0x38, 0x01, 63, 0x80}, // 59
+    {0x3C, 0x01, 63, 0x01}, // 60
+    {0x3D, 0x01, 63, 0x02}, // 61
+    {0x3E, 0x01, 63, 0x04}, // 62
+    {0x3F, 0x01, 63, 0x08}, // 63
+    {0x43, 0x01, 48, 0x10}, // 64
+    {0x42, 0x01, 48, 0x20}, // 65
+    {0x41, 0x01, 48, 0x40}, // 66
+    {0x40, 0x01, 48, 0x80}, // 67
+    {0x44, 0x01, 48, 0x01}, // 68
+    {0x45, 0x01, 48, 0x02}, // 69
+    {0x46, 0x01, 48, 0x04}, // 70
+    {0x47, 0x01, 48, 0x08}, // 71
+    {0x4B, 0x01, 49, 0x10}, // 72
+    {0x4A, 0x01, 49, 0x20}, // 73
+    {0x49, 0x01, 49, 0x40}, // 74
+    {0x48, 0x01, 49, 0x80}, // 75
+    {0x4C, 0x01, 49, 0x01}, // 76
+    {0x4D, 0x01, 49, 0x02}, // 77
+    {0x4E, 0x01, 49, 0x04}, // 78
+    {0x4F, 0x01, 49, 0x08}, // 79
+    {0x53, 0x01, 50, 0x10}, // 80
+    {0x52, 0x01, 50, 0x20}, // 81
+    {0x51, 0x01, 50, 0x40}, // 82
+    {0x50, 0x01, 50, 0x80}, // 83
+    {0x54, 0x01, 50, 0x01}, // 84
+    {0x55, 0x01, 50, 0x02}, // 85
+    {0x56, 0x01, 50, 0x04}, // 86
+    {0x57, 0x01, 50, 0x08}, // 87
+    {0x5B, 0x01, 51, 0x10}, // 88
+    {0x5A, 0x01, 51, 0x20}, // 89
+    {0x59, 0x01, 51, 0x40}, // 90
+    {0x58, 0x01, 51, 0x80}, // 91
+    {0x5C, 0x01, 51, 0x01}, // 92
+    {0x5D, 0x01, 51, 0x02}, // 93
+    {0x5E, 0x01, 51, 0x04}, // 94
+    {0x5F, 0x01, 51, 0x08}, // 95
+    {0x63, 0x01, 52, 0x10}, // 96
+    {0x62, 0x01, 52, 0x20}, // 97
+    {0x61, 0x01, 52, 0x40}, // 98
+    {0x60, 0x01, 52, 0x80}, // 99
+    {0x64, 0x01, 52, 0x01}, // 100
+    {0x65, 0x01, 52, 0x02}, // 101
+    {0x66, 0x01, 52, 0x04}, // 102
+    {0x67, 0x01, 52, 0x08}, // 103
+    {0x6B, 0x01, 53, 0x10}, // 104
+    {0x6A, 0x01, 53, 0x20}, // 105
+    {0x69, 0x01, 53, 0x40}, // 106
+    {0x68, 0x01, 53, 0x80}, // 107
+    {0x6C, 0x01, 53, 0x01}, // 108
+    {0x6D, 0x01, 53, 0x02}, // 109
+    {0x6E, 0x01, 53, 0x04}, // 110
+    {0x6F, 0x01, 53, 0x08}, // 111
+    {0x73, 0x01, 54, 0x10}, // 112
+    {0x72, 0x01, 54, 0x20}, // 113
+    {0x71, 0x01, 54, 0x40}, // 114
+    {0x70, 0x01, 54, 0x80}, // 115
+    {0x74, 0x01, 54, 0x01}, // 116
+    {0x75, 0x01, 54, 0x02}, // 117
+    {0x76, 0x01, 54, 0x04}, // 118
+    {0x77, 0x01, 54, 0x08}, // 119
+    {0x7B, 0x01, 55, 0x10}, // 120
+    {0x7A, 0x01, 55, 0x20}, // 121
+    {0x79, 0x01, 55, 0x40}, // 122
+    {0x78, 0x01, 55, 0x80}, // 123
+    {0x7C, 0x01, 55, 0x01}, // 124
+    {0x7D, 0x01, 55, 0x02}, // 125
+    {0x7E, 0x01, 55, 0x04}, // 126
+    {0x7F, 0x01, 55, 0x08}, // 127
+    {0x83, 0x01, 40, 0x10}, // 128
+    {0x82, 0x01, 40, 0x20}, // 129
+    {0x81, 0x01, 40, 0x40}, // 130
+    {0x80, 0x01, 40, 0x80}, // 131
+    {0x84, 0x01, 40, 0x01}, // 132
+    {0x85, 0x01, 40, 0x02}, // 133
+    {0x86, 0x01, 40, 0x04}, // 134
+    {0x87, 0x01, 40, 0x08}, // 135
+    {0x8B, 0x01, 41, 0x10}, // 136
+    {0x8A, 0x01, 41, 0x20}, // 137
+    {0x89, 0x01, 41, 0x40}, // 138
+    {0x88, 0x01, 41, 0x80}, // 139
+    {0x8C, 0x01, 41, 0x01}, // 140
+    {0x8D, 0x01, 41, 0x02}, // 141
+    {0x8E, 0x01, 41, 0x04}, // 142
+    {0x8F, 0x01, 41, 0x08}, // 143
+    {0x93, 0x01, 42, 0x10}, // 144
+    {0x92, 0x01, 42, 0x20}, // 145
+    {0x91, 0x01, 42, 0x40}, // 146
+    {0x90, 0x01, 42, 0x80}, // 147
+    {0x94, 0x01, 42, 0x01}, // 148
+    {0x95, 0x01, 42, 0x02}, // 149
+    {0x96, 0x01, 42, 0x04}, // 150
+    {0x97, 0x01, 42, 0x08}, // 151
+    {0x9B, 0x01, 43, 0x10}, // 152
+    {0x9A, 0x01, 43, 0x20}, // 153
+    {0x99, 0x01, 43, 0x40}, // 154
+    {0x98, 0x01, 43, 0x80}, // 155
+    {0x9C, 0x01, 43, 0x01}, // 156
+    {0x9D, 0x01, 43, 0x02}, // 157
+    {0x9E, 0x01, 43, 0x04}, // 158
+    {0x9F, 0x01, 43, 0x08}, // 159
+    {0xA3, 0x01, 44, 0x10}, // 160
+    {0xA2, 0x01, 44, 0x20}, // 161
+    {0xA1, 0x01, 44, 0x40}, // 162
+    {0xA0, 0x01, 44, 0x80}, // 163
+    {0xA4, 0x01, 44, 0x01}, // 164
+    {0xA5, 0x01, 44, 0x02}, // 165
+    {0xA6, 0x01, 44, 0x04}, // 166
+    {0xA7, 0x01, 44, 0x08}, // 167
+    {0xAB, 0x01, 45, 0x10}, // 168
+    {0xAA, 0x01, 45, 0x20}, // 169
+    {0xA9, 0x01, 45, 0x40}, // 170
+    {0xA8, 0x01, 45, 0x80}, // 171
+    {0xAC, 0x01, 45, 0x01}, // 172
+    {0xAD, 0x01, 45, 0x02}, // 173
+    {0xAE, 0x01, 45, 0x04}, // 174
+    {0xAF, 0x01, 45, 0x08}, // 175
+    {0xB3, 0x01, 46, 0x10}, // 176
+    {0xB2, 0x01, 46, 0x20}, // 177
+    {0xB1, 0x01, 46, 0x40}, // 178
+    {0xB0, 0x01, 46, 0x80}, // 179
+    {0xB4, 0x01, 46, 0x01}, // 180
+    {0xB5, 0x01, 46, 0x02}, // 181
+    {0xB6, 0x01, 46, 0x04}, // 182
+    {0xB7, 0x01, 46, 0x08}, // 183
+    {0xBB, 0x01, 47, 0x10}, // 184
+    {0xBA, 0x01, 47, 0x20}, // 185
+    {0xB9, 0x01, 47, 0x40}, // 186
+    {0xB8, 0x01, 47, 0x80}, // 187
+    {0xBC, 0x01, 47, 0x01}, // 188
+    {0xBD, 0x01, 47, 0x02}, // 189
+    {0xBE, 0x01, 47, 0x04}, // 190
+    {0xBF, 0x01, 47, 0x08}, // 191
+    {0xC3, 0x01, 32, 0x10}, // 192
+    {0xC2, 0x01, 32, 0x20}, // 193
+    {0xC1, 0x01, 32, 0x40}, // 194
+    {0xC0, 0x01, 32, 0x80}, // 195
+    {0xC4, 0x01, 32, 0x01}, // 196
+    {0xC5, 0x01, 32, 0x02}, // 197
+    {0xC6, 0x01, 32, 0x04}, // 198
+    {0xC7, 0x01, 32, 0x08}, // 199
+    {0xCB, 0x01, 33, 0x10}, // 200
+    {0xCA, 0x01, 33, 0x20}, // 201
+    {0xC9, 0x01, 33, 0x40}, // 202
+    {0xC8, 0x01, 33, 0x80}, // 203
+    {0xCC, 0x01, 33, 0x01}, // 204
+    {0xCD, 0x01, 33, 0x02}, // 205
+    {0xCE, 0x01, 33, 0x04}, // 206
+    {0xCF, 0x01, 33, 0x08}, // 207
+    {0xD3, 0x01, 34, 0x10}, // 208
+    {0xD2, 0x01, 34, 0x20}, // 209
+    {0xD1, 0x01, 34, 0x40}, // 210
+    {0xD0, 0x01, 34, 0x80}, // 211
+    {0xD4, 0x01, 34, 0x01}, // 212
+    {0xD5, 0x01, 34, 0x02}, // 213
+    {0xD6, 0x01, 34, 0x04}, // 214
+    {0xD7, 0x01, 34, 0x08}, // 215
+    {0xDB, 0x01, 35, 0x10}, // 216
+    {0xDA, 0x01, 35, 0x20}, // 217
+    {0xD9, 0x01, 35, 0x40}, // 218
+    {0xD8, 0x01, 35, 0x80}, // 219
+    {0xDC, 0x01, 35, 0x01}, // 220
+    {0xDD, 0x01, 35, 0x02}, // 221
+    {0xDE, 0x01, 35, 0x04}, // 222
+    {0xDF, 0x01, 35, 0x08}, // 223
+    {0xE3, 0x01, 36, 0x10}, // 224
+    {0xE2, 0x01, 36, 0x20}, // 225
+    {0xE1, 0x01, 36, 0x40}, // 226
+    {0xE0, 0x01, 36, 0x80}, // 227
+    {0xE4, 0x01, 36, 0x01}, // 228
+    {0xE5, 0x01, 36, 0x02}, // 229
+    {0xE6, 0x01, 36, 0x04}, // 230
+    {0xE7, 0x01, 36, 0x08}, // 231
+    {0xEB, 0x01, 37, 0x10}, // 232
+    {0xEA, 0x01, 37, 0x20}, // 233
+    {0xE9, 0x01, 37, 0x40}, // 234
+    {0xE8, 0x01, 37, 0x80}, // 235
+    {0xEC, 0x01, 37, 0x01}, // 236
+    {0xED, 0x01, 37, 0x02}, // 237
+    {0xEE, 0x01, 37, 0x04}, // 238
+    {0xEF, 0x01, 37, 0x08}, // 239
+    {0xF3, 0x01, 38, 0x10}, // 240
+    {0xF2, 0x01, 38, 0x20}, // 241
+    {0xF1, 0x01, 38, 0x40}, // 242
+    {0xF0, 0x01, 38, 0x80}, // 243
+    {0xF4, 0x01, 38, 0x01}, // 244
+    {0xF5, 0x01, 38, 0x02}, // 245
+    {0xF6, 0x01, 38, 0x04}, // 246
+    {0xF7, 0x01, 38, 0x08}, // 247
+    {0xFB, 0x01, 39, 0x10}, // 248
+    {0xFA, 0x01, 39, 0x20}, // 249
+    {0xF9, 0x01, 39, 0x40}, // 250
+    {0xF8, 0x01, 39, 0x80}, // 251
+    {0xFC, 0x01, 39, 0x01}, // 252
+    {0xFD, 0x01, 39, 0x02}, // 253
+    {0xFE, 0x01, 39, 0x04}, // 254
+    {0xFF, 0x01, 39, 0x08}, // 255
+    {0xC3, 0x00, 24, 0x10}, // 256
+    {0xC2, 0x00, 24, 0x20}, // 257
+    {0xC1, 0x00, 24, 0x40}, // 258
+    {0xC0, 0x00, 24, 0x80}, // 259
+    {0xC4, 0x00, 24, 0x01}, // 260
+    {0xC5, 0x00, 24, 0x02}, // 261
+    {0xC6, 0x00, 24, 0x04}, // 262
+    {0xC7, 0x00, 24, 0x08}, // 263
+    {0xCB, 0x00, 25, 0x10}, // 264
+    {0xCA, 0x00, 25, 0x20}, // 265
+    {0xC9, 0x00, 25, 0x40}, // 266
+    {0xC8, 0x00, 25, 0x80}, // 267
+    {0xCC, 0x00, 25, 0x01}, // 268
+    {0xCD, 0x00, 25, 0x02}, // 269
+    {0xCE, 0x00, 25, 0x04}, // 270
+    {0xCF, 0x00, 25, 0x08}, // 271
+    {0xD3, 0x00, 26, 0x10}, // 272
+    {0xD2, 0x00, 26, 0x20}, // 273
+    {0xD1, 0x00, 26, 0x40}, // 274
+    {0xD0, 0x00, 26, 0x80}, // 275
+    {0xD4, 0x00, 26, 0x01}, // 276
+    {0xD5, 0x00, 26, 0x02}, // 277
+    {0xD6, 0x00, 26, 0x04}, // 278
+    {0xD7, 0x00, 26, 0x08}, // 279
+    {0xDB, 0x00, 27, 0x10}, // 280
+    {0xDA, 0x00, 27, 0x20}, // 281
+    {0xD9, 0x00, 27, 0x40}, // 282
+    {0xD8, 0x00, 27, 0x80}, // 283
+    {0xDC, 0x00, 27, 0x01}, // 284
+    {0xDD, 0x00, 27, 0x02}, // 285
+    {0xDE, 0x00, 27, 0x04}, // 286
+    {0xDF, 0x00, 27, 0x08}, // 287
+    {0xE3, 0x00, 28, 0x10}, // 288
+    {0xE2, 0x00, 28, 0x20}, // 289
+    {0xE1, 0x00, 28, 0x40}, // 290
+    {0xE0, 0x00, 28, 0x80}, // 291
+    {0xE4, 0x00, 28, 0x01}, // 292
+    {0xE5, 0x00, 28, 0x02}, // 293
+    {0xE6, 0x00, 28, 0x04}, // 294
+    {0xE7, 0x00, 28, 0x08}, // 295
+    {0xEB, 0x00, 29, 0x10}, // 296
+    {0xEA, 0x00, 29, 0x20}, // 297
+    {0xE9, 0x00, 29, 0x40}, // 298
+    {0xE8, 0x00, 29, 0x80}, // 299
+    {0xEC, 0x00, 29, 0x01}, // 300
+    {0xED, 0x00, 29, 0x02}, // 301
+    {0xEE, 0x00, 29, 0x04}, // 302
+    {0xEF, 0x00, 29, 0x08}, // 303
+    {0xF3, 0x00, 30, 0x10}, // 304
+    {0xF2, 0x00, 30, 0x20}, // 305
+    {0xF1, 0x00, 30, 0x40}, // 306
+    {0xF0, 0x00, 30, 0x80}, // 307
+    {0xF4, 0x00, 30, 0x01}, // 308
+    {0xF5, 0x00, 30, 0x02}, // 309
+    {0xF6, 0x00, 30, 0x04}, // 310
+    {0xF7, 0x00, 30, 0x08}, // 311
+    {0xFB, 0x00, 31, 0x10}, // 312
+    {0xFA, 0x00, 31, 0x20}, // 313
+    {0xF9, 0x00, 31, 0x40}, // 314
+    {0xF8, 0x00, 31, 0x80}, // 315
+    {0xFC, 0x00, 31, 0x01}, // 316
+    {0xFD, 0x00, 31, 0x02}, // 317
+    {0xFE, 0x00, 31, 0x04}, // 318
+    {0xFF, 0x00, 31, 0x08}, // 319
+    {0x83, 0x00, 16, 0x10}, // 320
+    {0x82, 0x00, 16, 0x20}, // 321
+    {0x81, 0x00, 16, 0x40}, // 322
+    {0x80, 0x00, 16, 0x80}, // 323
+    {0x84, 0x00, 16, 0x01}, // 324
+    {0x85, 0x00, 16, 0x02}, // 325
+    {0x86, 0x00, 16, 0x04}, // 326
+    {0x87, 0x00, 16, 0x08}, // 327
+    {0x8B, 0x00, 17, 0x10}, // 328
+    {0x8A, 0x00, 17, 0x20}, // 329
+    {0x89, 0x00, 17, 0x40}, // 330
+    {0x88, 0x00, 17, 0x80}, // 331
+    {0x8C, 0x00, 17, 0x01}, // 332
+    {0x8D, 0x00, 17, 0x02}, // 333
+    {0x8E, 0x00, 17, 0x04}, // 334
+    {0x8F, 0x00, 17, 0x08}, // 335
+    {0x93, 0x00, 18, 0x10}, // 336
+    {0x92, 0x00, 18, 0x20}, // 337
+    {0x91, 0x00, 18, 0x40}, // 338
+    {0x90, 0x00, 18, 0x80}, // 339
+    {0x94, 0x00, 18, 0x01}, // 340
+    {0x95, 0x00, 18, 0x02}, // 341
+    {0x96, 0x00, 18, 0x04}, // 342
+    {0x97, 0x00, 18, 0x08}, // 343
+    {0x9B, 0x00, 19, 0x10}, // 344
+    {0x9A, 0x00, 19, 0x20}, // 345
+    {0x99, 0x00, 19, 0x40}, // 346
+    {0x98, 0x00, 19, 0x80}, // 347
+    {0x9C, 0x00, 19, 0x01}, // 348
+    {0x9D, 0x00, 19, 0x02}, // 349
+    {0x9E, 0x00, 19, 0x04}, // 350
+    {0x9F, 0x00, 19, 0x08}, // 351
+    {0xA3, 0x00, 20, 0x10}, // 352
+    {0xA2, 0x00, 20, 0x20}, // 353
+    {0xA1, 0x00, 20, 0x40}, // 354
+    {0xA0, 0x00, 20, 0x80}, // 355
+    {0xA4, 0x00, 20, 0x01}, // 356
+    {0xA5, 0x00, 20, 0x02}, // 357
+    {0xA6, 0x00, 20, 0x04}, // 358
+    {0xA7, 0x00, 20, 0x08}, // 359
+    {0xAB, 0x00, 21, 0x10}, // 360
+    {0xAA, 0x00, 21, 0x20}, // 361
+    {0xA9, 0x00, 21, 0x40}, // 362
+    {0xA8, 0x00, 21, 0x80}, // 363
+    {0xAC, 0x00, 21, 0x01}, // 364
+    {0xAD, 0x00, 21, 0x02}, // 365
+    {0xAE, 0x00, 21, 0x04}, // 366
+    {0xAF, 0x00, 21, 0x08}, // 367
+    {0xB3, 0x00, 22, 0x10}, // 368
+    {0xB2, 0x00, 22, 0x20}, // 369
+    {0xB1, 0x00, 22, 0x40}, // 370
+    {0xB0, 0x00, 22, 0x80}, // 371
+    {0xB4, 0x00, 22, 0x01}, // 372
+    {0xB5, 0x00, 22, 0x02}, // 373
+    {0xB6, 0x00, 22, 0x04}, // 374
+    {0xB7, 0x00, 22, 0x08}, // 375
+    {0xBB, 0x00, 23, 0x10}, // 376
+    {0xBA, 0x00, 23, 0x20}, // 377
+    {0xB9, 0x00, 23, 0x40}, // 378
+    {0xB8, 0x00, 23, 0x80}, // 379
+    {0xBC, 0x00, 23, 0x01}, // 380
+    {0xBD, 0x00, 23, 0x02}, // 381
+    {0xBE, 0x00, 23, 0x04}, // 382
+    {0xBF, 0x00, 23, 0x08}, // 383
+    {0x43, 0x00,  8, 0x10}, // 384
+    {0x42, 0x00,  8, 0x20}, // 385
+    {0x41, 0x00,  8, 0x40}, // 386
+    {0x40, 0x00,  8, 0x80}, // 387
+    {0x44, 0x00,  8, 0x01}, // 388
+    {0x45, 0x00,  8, 0x02}, // 389
+    {0x46, 0x00,  8, 0x04}, // 390
+    {0x47, 0x00,  8, 0x08}, // 391
+    {0x4B, 0x00,  9, 0x10}, // 392
+    {0x4A, 0x00,  9, 0x20}, // 393
+    {0x49, 0x00,  9, 0x40}, // 394
+    {0x48, 0x00,  9, 0x80}, // 395
+    {0x4C, 0x00,  9, 0x01}, // 396
+    {0x4D, 0x00,  9, 0x02}, // 397
+    {0x4E, 0x00,  9, 0x04}, // 398
+    {0x4F, 0x00,  9, 0x08}, // 399
+    {0x53, 0x00, 10, 0x10}, // 400
+    {0x52, 0x00, 10, 0x20}, // 401
+    {0x51, 0x00, 10, 0x40}, // 402
+    {0x50, 0x00, 10, 0x80}, // 403
+    {0x54, 0x00, 10, 0x01}, // 404
+    {0x55, 0x00, 10, 0x02}, // 405
+    {0x56, 0x00, 10, 0x04}, // 406
+    {0x57, 0x00, 10, 0x08}, // 407
+    {0x5B, 0x00, 11, 0x10}, // 408
+    {0x5A, 0x00, 11, 0x20}, // 409
+    {0x59, 0x00, 11, 0x40}, // 410
+    {0x58, 0x00, 11, 0x80}, // 411
+    {0x5C, 0x00, 11, 0x01}, // 412
+    {0x5D, 0x00, 11, 0x02}, // 413
+    {0x5E, 0x00, 11, 0x04}, // 414
+    {0x5F, 0x00, 11, 0x08}, // 415
+    {0x63, 0x00, 12, 0x10}, // 416
+    {0x62, 0x00, 12, 0x20}, // 417
+    {0x61, 0x00, 12, 0x40}, // 418
+    {0x60, 0x00, 12, 0x80}, // 419
+    {0x64, 0x00, 12, 0x01}, // 420
+    {0x65, 0x00, 12, 0x02}, // 421
+    {0x66, 0x00, 12, 0x04}, // 422
+    {0x67, 0x00, 12, 0x08}, // 423
+    {0x6B, 0x00, 13, 0x10}, // 424
+    {0x6A, 0x00, 13, 0x20}, // 425
+    {0x69, 0x00, 13, 0x40}, // 426
+    {0x68, 0x00, 13, 0x80}, // 427
+    {0x6C, 0x00, 13, 0x01}, // 428
+    {0x6D, 0x00, 13, 0x02}, // 429
+    {0x6E, 0x00, 13, 0x04}, // 430
+    {0x6F, 0x00, 13, 0x08}, // 431
+    {0x73, 0x00, 14, 0x10}, // 432
+    {0x72, 0x00, 14, 0x20}, // 433
+    {0x71, 0x00, 14, 0x40}, // 434
+    {0x70, 0x00, 14, 0x80}, // 435
+    {0x74, 0x00, 14, 0x01}, // 436
+    {0x75, 0x00, 14, 0x02}, // 437
+    {0x76, 0x00, 14, 0x04}, // 438
+    {0x77, 0x00, 14, 0x08}, // 439
+    {0x7B, 0x00, 15, 0x10}, // 440
+    {0x7A, 0x00, 15, 0x20}, // 441
+    {0x79, 0x00, 15, 0x40}, // 442
+    {0x78, 0x00, 15, 0x80}, // 443
+    {0x7C, 0x00, 15, 0x01}, // 444
+    {0x7D, 0x00, 15, 0x02}, // 445
+    {0x7E, 0x00, 15, 0x04}, // 446
+    {0x7F, 0x00, 15, 0x08}, // 447
+    {0x03, 0x00,  0, 0x10}, // 448
+    {0x02, 0x00,  0, 0x20}, // 449
+    {0x01, 0x00,  0, 0x40}, // 450
+    {0x00, 0x00,  0, 0x80}, // 451
+    {0x04, 0x00,  0, 0x01}, // 452
+    {0x05, 0x00,  0, 0x02}, // 453
+    {0x06, 0x00,  0, 0x04}, // 454
+    {0x07, 0x00,  0, 0x08}, // 455
+    {0x0B, 0x00,  1, 0x10}, // 456
+    {0x0A, 0x00,  1, 0x20}, // 457
+    {0x09, 0x00,  1, 0x40}, // 458
+    {0x08, 0x00,  1, 0x80}, // 459
+    {0x0C, 0x00,  1, 0x01}, // 460
+    {0x0D, 0x00,  1, 0x02}, // 461
+    {0x0E, 0x00,  1, 0x04}, // 462
+    {0x0F, 0x00,  1, 0x08}, // 463
+    {0x13, 0x00,  2, 0x10}, // 464
+    {0x12, 0x00,  2, 0x20}, // 465
+    {0x11, 0x00,  2, 0x40}, // 466
+    {0x10, 0x00,  2, 0x80}, // 467
+    {0x14, 0x00,  2, 0x01}, // 468
+    {0x15, 0x00,  2, 0x02}, // 469
+    {0x16, 0x00,  2, 0x04}, // 470
+    {0x17, 0x00,  2, 0x08}, // 471
+    {0x1B, 0x00,  3, 0x10}, // 472
+    {0x1A, 0x00,  3, 0x20}, // 473
+    {0x19, 0x00,  3, 0x40}, // 474
+    {0x18, 0x00,  3, 0x80}, // 475
+    {0x1C, 0x00,  3, 0x01}, // 476
+    {0x1D, 0x00,  3, 0x02}, // 477
+    {0x1E, 0x00,  3, 0x04}, // 478
+    {0x1F, 0x00,  3, 0x08}, // 479
+    {0x23, 0x00,  4, 0x10}, // 480
+    {0x22, 0x00,  4, 0x20}, // 481
+    {0x21, 0x00,  4, 0x40}, // 482
+    {0x20, 0x00,  4, 0x80}, // 483
+    {0x24, 0x00,  4, 0x01}, // 484
+    {0x25, 0x00,  4, 0x02}, // 485
+    {0x26, 0x00,  4, 0x04}, // 486
+    {0x27, 0x00,  4, 0x08}, // 487
+    {0x2B, 0x00,  5, 0x10}, // 488
+    {0x2A, 0x00,  5, 0x20}, // 489
+    {0x29, 0x00,  5, 0x40}, // 490
+    {0x28, 0x00,  5, 0x80}, // 491
+    {0x2C, 0x00,  5, 0x01}, // 492
+    {0x2D, 0x00,  5, 0x02}, // 493
+    {0x2E, 0x00,  5, 0x04}, // 494
+    {0x2F, 0x00,  5, 0x08}, // 495
+    {0x33, 0x00,  6, 0x10}, // 496
+    {0x32, 0x00,  6, 0x20}, // 497
+    {0x31, 0x00,  6, 0x40}, // 498
+    {0x30, 0x00,  6, 0x80}, // 499
+    {0x34, 0x00,  6, 0x01}, // 500
+    {0x35, 0x00,  6, 0x02}, // 501
+    {0x36, 0x00,  6, 0x04}, // 502
+    {0x37, 0x00,  6, 0x08}, // 503
+    {0x3B, 0x00,  7, 0x10}, // 504
+    {0x3A, 0x00,  7, 0x20}, // 505
+    {0x39, 0x00,  7, 0x40}, // 506
+    {0x38, 0x00,  7, 0x80}, // 507
+    {0x3C, 0x00,  7, 0x01}, // 508
+    {0x3D, 0x00,  7, 0x02}, // 509
+    {0x3E, 0x00,  7, 0x04}, // 510
+    {0x3F, 0x00,  7, 0x08}, // 511
+};
@@ -0,0 +1,55 @@
+/**
+ *  \file
+ *
+ *  \brief Switching matrix channel lookup table.
+ *
+ *  For every channel the table holds the multiplexer address
+ *  (PORTC and PD0) and position of the channel switch in the chain frame.
+ *  The table is generated by gen_swchnmap.sh for the default geometry,
+ *  chain positions of other geometries are computed by swgeometry.
+ *  The accessors take logical channels and look up the physical ones in
+ *  the probe card map first.
+ */
+
+#ifndef _SWCHNMAP_H__
+#define _SWCHNMAP_H__
+
+#include "swgeometry.h"
+#include "swmap.h"
+#include "types.h"
+
+#define SWCHNMAP_CHANNELS 512
+
+typedef struct swchnmap_entry_struct {
+  uint8_t addrLo;    // PORTC (A0-A7)
+  uint8_t addrHi;    // PD0 (A8)
+  uint8_t chainByte; // index of the chip in the chain frame
+  uint8_t chainMask; // switch of the channel in the chip
+} swchnmap_entry_t;
+
+extern const swchnmap_entry_t swchnmap[SWCHNMAP_CHANNELS] IMMUTABLE_MEM;
+
+static inline uint8_t swchnmap_addr_lo(uint16_t chn) {
+  chn = swmap_physical(chn);
+  return READ_IMMUTABLE_BYTE(&swchnmap[chn & swgeometry_addr_mask].addrLo);
+}
+
+static inline uint8_t swchnmap_addr_hi(uint16_t chn) {
+  chn = swmap_physical(chn);
+  return READ_IMMUTABLE_BYTE(&swchnmap[chn & swgeometry_addr_mask].addrHi);
+}
+
+static inline uint16_t swchnmap_chain_byte(uint16_t chn) {
+  chn = swmap_physical(chn);
+  if (swgeometry_custom)
+    return swgeometry_chain_byte(chn);
+  return READ_IMMUTABLE_BYTE(&swchnmap[chn % SWCHNMAP_CHANNELS].chainByte);
+}
+
+// depends only on the position of the channel in its chip
+static inline uint8_t swchnmap_chain_mask(uint16_t chn) {
+  chn = swmap_physical(chn);
+  return READ_IMMUTABLE_BYTE(&swchnmap[chn % SWCHNMAP_CHANNELS].chainMask);
+}
+
+#endif // !_SWCHNMAP_H__
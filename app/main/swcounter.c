@@ -0,0 +1,272 @@
+/**
+ *  \file
+ *
+ *  \brief Switch actuation counters
+ *
+ *  The RAM counters are 8 bit wide and only hold the actuations since the
+ *  last flush. The totals are 24 bit wide and stored in EEPROM, ten to a
+ *  page, so flushing a switch rewrites only the page it's in, and only the
+ *  pages marked dirty by a count are looked at. The matrix task flushes the
+ *  counters between its requests once the matrix was idle for a while, at
+ *  the latest after SWCOUNTER_FLUSH_PERIOD_S, or earlier if a counter is
+ *  close to saturation.
+ */
+
+#include "swcounter.h"
+#include "astring.h"
+#include "cli.h"
+#include "cmdarg.h"
+#include "config_file.h"
+#include "eeprom_driver.h"
+#include "mt.h"
+#include "swchnmap.h"
+#include "swgeometry.h"
+#include <avr/interrupt.h>
+#include <string.h>
+
+#define SWCOUNTER_PER_PAGE 10
+#define SWCOUNTER_PAGES                                                        \
+  ((SWCOUNTER_SWITCHES + SWCOUNTER_PER_PAGE - 1) / SWCOUNTER_PER_PAGE)
+
+// ATxmega128A1 has 2 KB of EEPROM
+#if CONFIGFILE_SWCOUNTER + SWCOUNTER_PAGES * EEPROM_PAGESIZE > 0x800
+#error "Actuation counters don't fit in the EEPROM"
+#endif
+
+// stored in the spare bytes of every page, changes with the layout
+#define SWCOUNTER_MAGIC 0xC5
+#define SWCOUNTER_MAGIC_OFFSET (SWCOUNTER_PER_PAGE * 3)
+
+// a flush is requested when a counter reaches this value
+#define SWCOUNTER_URGENT 0x80
+
+static uint8_t pending[SWCOUNTER_SWITCHES];
+static uint8_t dirty[(SWCOUNTER_PAGES + 7) / 8]; // pages with pending counts
+static volatile bool active; // counted since the last poll
+static volatile bool urgent;
+static volatile uint32_t lost;
+static uint32_t idleSince; // OS ticks
+static uint32_t cleanTime; // OS ticks, last time nothing was pending
+static MT_SemType lock;
+
+static void swcounter_mark(uint16_t sw) {
+  uint8_t page = sw / SWCOUNTER_PER_PAGE;
+  dirty[page / 8] |= 1 << (page % 8);
+}
+
+void swcounter_count(uint16_t chip, uint8_t toggled) {
+  if (chip >= SWCOUNTER_MAX_CHIPS)
+    return;
+  // the chain is owned by a single task or by the trigger ISR at a time,
+  // the flush clears the counters with interrupts disabled
+  // a chip spans two pages at most
+  swcounter_mark(chip * 8);
+  swcounter_mark(chip * 8 + 7);
+  uint8_t *p = &pending[chip * 8];
+  for (; toggled; toggled >>= 1, p++) {
+    if (!(toggled & 1))
+      continue;
+    if (*p == 0xff)
+      lost++;
+    else if (++*p == SWCOUNTER_URGENT)
+      urgent = true;
+  }
+  active = true;
+}
+
+static uint16_t swcounter_page_id(uint8_t page) {
+  return CONFIGFILE_SWCOUNTER + page * EEPROM_PAGESIZE;
+}
+
+static void swcounter_load_page(uint8_t page, uint8_t *buf) {
+  ConfigFile_Load(swcounter_page_id(page), buf, EEPROM_PAGESIZE);
+  // erased EEPROM reads as 0xff
+  if (buf[SWCOUNTER_MAGIC_OFFSET] != SWCOUNTER_MAGIC) {
+    memset(buf, 0, EEPROM_PAGESIZE);
+    buf[SWCOUNTER_MAGIC_OFFSET] = SWCOUNTER_MAGIC;
+  }
+}
+
+static uint32_t swcounter_total(const uint8_t *buf, uint8_t i) {
+  const uint8_t *p = &buf[i * 3];
+  return p[0] | (uint16_t)p[1] << 8 | (uint32_t)p[2] << 16;
+}
+
+static void swcounter_flush_page(uint8_t page) {
+  uint8_t bit = 1 << (page % 8);
+  uint8_t marked;
+  // counted again after this, the page gets marked again
+  MT_ATOMIC_EXPR((marked = dirty[page / 8] & bit, dirty[page / 8] &= ~bit));
+  if (!marked)
+    return;
+  uint16_t first = page * SWCOUNTER_PER_PAGE;
+  uint8_t n = SWCOUNTER_PER_PAGE;
+  if (first + n > SWCOUNTER_SWITCHES)
+    n = SWCOUNTER_SWITCHES - first;
+
+  uint8_t i;
+  for (i = 0; i < n && !pending[first + i]; i++)
+    ;
+  if (i == n)
+    return;
+
+  uint8_t buf[EEPROM_PAGESIZE];
+  swcounter_load_page(page, buf);
+  for (i = 0; i < n; i++) {
+    uint8_t count;
+    uint8_t sreg = SREG;
+    cli();
+    count = pending[first + i];
+    pending[first + i] = 0;
+    SREG = sreg;
+    uint32_t total = swcounter_total(buf, i) + count;
+    if (total > SWCOUNTER_MAX_TOTAL)
+      total = SWCOUNTER_MAX_TOTAL;
+    buf[i * 3] = total;
+    buf[i * 3 + 1] = total >> 8;
+    buf[i * 3 + 2] = total >> 16;
+  }
+  ConfigFile_Save(swcounter_page_id(page), buf, EEPROM_PAGESIZE);
+}
+
+static void swcounter_lock(void) {
+  if (lock)
+    MT_SEM_PEND(lock, 0);
+}
+
+static void swcounter_unlock(void) {
+  if (lock)
+    MT_SEM_POST(lock);
+}
+
+result_t swcounter_flush(void) {
+  swcounter_lock();
+  urgent = false;
+  for (uint8_t page = 0; page < SWCOUNTER_PAGES; page++)
+    swcounter_flush_page(page);
+  swcounter_unlock();
+  return RESULT_OK;
+}
+
+result_t swcounter_clear(void) {
+  uint8_t buf[EEPROM_PAGESIZE];
+  memset(buf, 0, sizeof(buf));
+  buf[SWCOUNTER_MAGIC_OFFSET] = SWCOUNTER_MAGIC;
+  swcounter_lock();
+  uint8_t sreg = SREG;
+  cli();
+  memset(pending, 0, sizeof(pending));
+  memset(dirty, 0, sizeof(dirty));
+  SREG = sreg;
+  for (uint8_t page = 0; page < SWCOUNTER_PAGES; page++)
+    ConfigFile_Save(swcounter_page_id(page), buf, EEPROM_PAGESIZE);
+  MT_ATOMIC_EXPR(lost = 0);
+  urgent = false;
+  swcounter_unlock();
+  return RESULT_OK;
+}
+
+uint32_t swcounter_get(uint16_t sw) {
+  if (sw >= SWCOUNTER_SWITCHES)
+    return 0;
+  uint8_t buf[EEPROM_PAGESIZE];
+  swcounter_lock();
+  swcounter_load_page(sw / SWCOUNTER_PER_PAGE, buf);
+  uint32_t total = swcounter_total(buf, sw % SWCOUNTER_PER_PAGE);
+  total += pending[sw];
+  swcounter_unlock();
+  return total;
+}
+
+uint16_t swcounter_get_pending(void) {
+  uint16_t n = 0;
+  for (uint16_t sw = 0; sw < SWCOUNTER_SWITCHES; sw++)
+    if (pending[sw])
+      n++;
+  return n;
+}
+
+uint32_t swcounter_get_lost(void) {
+  uint32_t n;
+  MT_ATOMIC_EXPR(n = lost);
+  return n;
+}
+
+static bool swcounter_is_dirty(void) {
+  for (uint8_t i = 0; i < sizeof(dirty); i++)
+    if (dirty[i])
+      return true;
+  return false;
+}
+
+void swcounter_poll(void) {
+  uint32_t now = OSTimeGet();
+  if (active) {
+    active = false;
+    idleSince = now;
+  }
+  // nothing counted since the last flush
+  if (!swcounter_is_dirty()) {
+    cleanTime = now;
+    return;
+  }
+  // in seconds, the products would overflow an int
+  uint32_t idle = (now - idleSince) / OS_TICKS_PER_SEC;
+  uint32_t dirtyAge = (now - cleanTime) / OS_TICKS_PER_SEC;
+  if (idle >= SWCOUNTER_IDLE_S || dirtyAge >= SWCOUNTER_FLUSH_PERIOD_S ||
+      (urgent && dirtyAge >= SWCOUNTER_MIN_FLUSH_S))
+    swcounter_flush();
+}
+
+result_t swcounter_init(void) {
+  // semaphores can't be created before the OS is initialized
+  if (OSRunning && !lock && !MT_SEM_INIT(lock, 1))
+    return S("swcounter_init: Can't create semaphore");
+  return RESULT_OK;
+}
+
+//******************************************************************************
+// user interface
+//******************************************************************************
+
+/// Index of the switch of a channel in the counters.
+static uint16_t swcounter_switch(uint16_t chn) {
+  uint8_t mask = swchnmap_chain_mask(chn);
+  uint8_t bit = 0;
+  while (mask >>= 1)
+    bit++;
+  return swchnmap_chain_byte(chn) * 8 + bit;
+}
+
+// Eight counts per line in hex, preceded by the first channel in decimal
+static result_t swcounter_dump(void *pOut) {
+  uint16_t channels = swgeometry_channels();
+  for (uint16_t chn = 0; chn < channels; chn++) {
+    if (chn % 8 == 0)
+      CLI_TPRINTF_ASSERT("%u", chn);
+    CLI_TPRINTF_ASSERT(" %lx", swcounter_get(swcounter_switch(chn)));
+    if (chn % 8 == 7 || chn == channels - 1)
+      CLI_TPRINTF_ASSERT("\n");
+  }
+  return RESULT_OK;
+}
+
+DEFINE_COMMAND(ROOT_MATRIX, COUNTERS, NULL, pObj, args, pOut) {
+  args = skipSpaces(args);
+  // get status
+  if (strlen(args) == 0 || strcmp_P(args, S("?")) == 0)
+    return CLI_TPRINTF("PENDING %u LOST %lu", swcounter_get_pending(),
+                       swcounter_get_lost());
+  else if (stricmp_P(args, S("DUMP")) == 0)
+    return swcounter_dump(pOut);
+  else if (stricmp_P(args, S("FLUSH")) == 0)
+    return swcounter_flush();
+  else if (stricmp_P(args, S("CLEAR")) == 0)
+    return swcounter_clear();
+  // count of a single channel
+  int32_t chn;
+  result_t ret = parseInt(&args, 0, swgeometry_channels() - 1, &chn);
+  if (ret != RESULT_OK)
+    return S("Expected channel, DUMP, FLUSH, CLEAR or nothing");
+  return CLI_TPRINTF("%lu", swcounter_get(swcounter_switch(chn)));
+}
@@ -0,0 +1,62 @@
+/**
+ *  \file
+ *
+ *  \brief Switch actuation counters header file.
+ *
+ *  Every change of a switch state (open or short) is counted per switch,
+ *  i.e. per position in the chain, as that's what wears out. The counts
+ *  are kept in RAM and added to the totals in EEPROM in batches by the
+ *  matrix task between its requests, so switching never waits for the NVM.
+ */
+
+#ifndef _SWCOUNTER_H__
+#define _SWCOUNTER_H__
+
+#include "app_cfg.h"
+#include "types.h"
+
+/// Number of counters, one for each switch of the first chips of the chain.
+#define SWCOUNTER_SWITCHES (SWCOUNTER_MAX_CHIPS * 8)
+
+/// Largest total stored in EEPROM, the totals saturate at it.
+#define SWCOUNTER_MAX_TOTAL 0xffffffUL
+
+/** \brief Create the lock of the EEPROM totals.
+ *
+ *  Does nothing before the OS is running.
+ */
+result_t swcounter_init(void);
+
+/** \brief Flush the counters if it's due.
+ *
+ *  Called by the matrix task between requests, at least once a second.
+ */
+void swcounter_poll(void);
+
+/** \brief Count the switches of a chip which changed their state.
+ *
+ *  Called by the switch chain on every latch, from the task owning the
+ *  chain or from the trigger ISR.
+ *
+ *  \param[in]  chip     Index of the chip in the chain frame.
+ *  \param[in]  toggled  Mask of the switches which changed.
+ */
+void swcounter_count(uint16_t chip, uint8_t toggled);
+
+/// Total actuations of a switch, including the ones not flushed yet, 0 for
+/// a switch without counter.
+uint32_t swcounter_get(uint16_t sw);
+
+/// Add all pending counts to the totals in EEPROM.
+result_t swcounter_flush(void);
+
+/// Reset all totals to zero.
+result_t swcounter_clear(void);
+
+/// Number of switches with counts not flushed yet.
+uint16_t swcounter_get_pending(void);
+
+/// Actuations lost because a counter saturated before it was flushed.
+uint32_t swcounter_get_lost(void);
+
+#endif // !_SWCOUNTER_H__
@@ -0,0 +1,87 @@
+/**
+ *  \file
+ *
+ *  \brief Switching matrix geometry
+ *
+ *  The default geometry is served by the flash lookup table. Other
+ *  geometries compute the chain position of a channel with the layout
+ *  used by gen_swchnmap.sh, generalized to any number of rows and chips
+ *  per row. The position of the switch inside a chip and the multiplexer
+ *  address permutation depend only on the low channel bits and still come
+ *  from the table.
+ */
+
+#include "swgeometry.h"
+#include "config_file.h"
+#include "swchain.h"
+#include <string.h>
+
+// stored in EEPROM in front of the geometry, changes with its layout
+#define SWGEOMETRY_MAGIC 0xA2
+
+typedef struct {
+  uint8_t magic;
+  swgeometry_t geometry;
+} swgeometry_file_t;
+
+static const swgeometry_t defaultGeometry = {64, 8, SWGEOMETRY_MAX_ADDR_BITS};
+
+static swgeometry_t geometry = {64, 8, SWGEOMETRY_MAX_ADDR_BITS};
+bool swgeometry_custom;
+uint16_t swgeometry_addr_mask = (1 << SWGEOMETRY_MAX_ADDR_BITS) - 1;
+
+static result_t swgeometry_check(const swgeometry_t *pGeometry) {
+  if (pGeometry->chips < 1 || pGeometry->chips > SWCHAIN_MAX_CHIPS)
+    return S("Number of chips out of range");
+  if (pGeometry->rowChips < 1 || pGeometry->chips % pGeometry->rowChips)
+    return S("Number of chips must be a multiple of chips per row");
+  if (pGeometry->addrBits < 1 ||
+      pGeometry->addrBits > SWGEOMETRY_MAX_ADDR_BITS)
+    return S("Address width out of range");
+  return RESULT_OK;
+}
+
+result_t swgeometry_set(const swgeometry_t *pGeometry) {
+  result_t ret = swgeometry_check(pGeometry);
+  if (ret != RESULT_OK)
+    return ret;
+  ret = swchain_set_chips(pGeometry->chips);
+  if (ret != RESULT_OK)
+    return ret;
+  geometry = *pGeometry;
+  swgeometry_custom = memcmp(&geometry, &defaultGeometry, sizeof(geometry));
+  swgeometry_addr_mask = (1 << geometry.addrBits) - 1;
+  return RESULT_OK;
+}
+
+void swgeometry_get(swgeometry_t *pGeometry) { *pGeometry = geometry; }
+
+void swgeometry_init(void) {
+  swgeometry_file_t file;
+  ConfigFile_Load(CONFIGFILE_SWMATRIX_GEOMETRY, &file, sizeof(file));
+  // erased EEPROM reads as 0xff
+  if (file.magic != SWGEOMETRY_MAGIC ||
+      swgeometry_set(&file.geometry) != RESULT_OK)
+    swgeometry_set(&defaultGeometry);
+}
+
+result_t swgeometry_save(void) {
+  swgeometry_file_t file = {SWGEOMETRY_MAGIC, geometry};
+  return ConfigFile_Save(CONFIGFILE_SWMATRIX_GEOMETRY, &file, sizeof(file));
+}
+
+uint16_t swgeometry_channels(void) { return geometry.chips * 8; }
+
+uint16_t swgeometry_rows(void) { return geometry.chips / geometry.rowChips; }
+
+uint16_t swgeometry_row(uint16_t chn) {
+  return (chn % swgeometry_channels()) / 8 / geometry.rowChips;
+}
+
+uint16_t swgeometry_chain_byte(uint16_t chn) {
+  chn %= swgeometry_channels();
+  uint16_t rows = geometry.chips / geometry.rowChips;
+  uint16_t row = chn / 8 / geometry.rowChips;
+  uint16_t chip = (chn / 8) % geometry.rowChips;
+  return (rows - 1 - row) * geometry.rowChips + chip;
+}
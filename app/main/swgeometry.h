@@ -0,0 +1,60 @@
+/**
+ *  \file
+ *
+ *  \brief Switching matrix geometry header file.
+ *
+ *  The geometry describes the switch chain (number of chips and chips per
+ *  row) and the width of the multiplexer address. It's stored in EEPROM,
+ *  so one firmware image drives matrices of different sizes.
+ */
+
+#ifndef _SWGEOMETRY_H__
+#define _SWGEOMETRY_H__
+
+#include "types.h"
+
+/// Width of the multiplexer address wired on the board (A0-A8).
+#define SWGEOMETRY_MAX_ADDR_BITS 9
+
+typedef struct {
+  uint16_t chips;    // ADG714 chips in the chain
+  uint16_t rowChips; // chips per row, rows are shifted out from the last one
+  uint8_t addrBits;  // width of the multiplexer address
+} swgeometry_t;
+
+/// True if the geometry differs from the one of the channel lookup table.
+extern bool swgeometry_custom;
+/// Mask applied to channel numbers to get the multiplexer address index.
+extern uint16_t swgeometry_addr_mask;
+
+/** \brief Load the geometry from EEPROM and apply it.
+ *
+ *  Falls back to the default 64 chips in 8 rows with 9 address bits if
+ *  nothing valid is stored.
+ */
+void swgeometry_init(void);
+
+/** \brief Validate and apply a geometry.
+ *
+ *  The switch chain is reset, the caller has to make sure it's idle.
+ */
+result_t swgeometry_set(const swgeometry_t *pGeometry);
+
+void swgeometry_get(swgeometry_t *pGeometry);
+
+/// Store the current geometry in EEPROM.
+result_t swgeometry_save(void);
+
+/// Number of channels, i.e. of switches in the chain.
+uint16_t swgeometry_channels(void);
+
+/// Number of rows of chips.
+uint16_t swgeometry_rows(void);
+
+/// Row of a channel, rows are numbered in the channel order.
+uint16_t swgeometry_row(uint16_t chn);
+
+/// Index of the chip of a channel in the chain frame, for custom geometries.
+uint16_t swgeometry_chain_byte(uint16_t chn);
+
+#endif // !_SWGEOMETRY_H__
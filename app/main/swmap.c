@@ -0,0 +1,226 @@
+/**
+ *  \file
+ *
+ *  \brief Logical to physical channel map
+ *
+ *  A table of all channels doesn't fit the RAM, and probe cards map whole
+ *  blocks of pads anyway, so the map is a list of runs. A write merges the
+ *  new runs with the old map and rebuilds the list, identity runs left
+ *  out, adjacent runs joined. The lookup scans the list in RAM, which is
+ *  short enough for the trigger ISR.
+ */
+
+#include "swmap.h"
+#include "astring.h"
+#include "cli.h"
+#include "cmdarg.h"
+#include "config_file.h"
+#include "mt.h"
+#include "swgeometry.h"
+#include "swmatrix.h"
+#include <avr/interrupt.h>
+#include <string.h>
+
+// stored in EEPROM in front of the runs, changes with their layout
+#define SWMAP_MAGIC 0x3A
+
+typedef struct {
+  uint8_t magic;
+  uint8_t n;
+  swmap_run_t runs[SWMAP_MAX_RUNS];
+} swmap_file_t;
+
+static swmap_run_t map[SWMAP_MAX_RUNS];
+static uint8_t mapRuns;
+
+// runs printed per line by MATRIX.MAP.DUMP, fits the editor line
+#define SWMAP_DUMP_RUNS 4
+
+static bool swmap_lookup(const swmap_run_t *runs, uint8_t n, uint16_t chn,
+                         uint16_t *pPhys) {
+  for (uint8_t i = 0; i < n; i++) {
+    if (chn >= runs[i].logical && chn - runs[i].logical < runs[i].count) {
+      *pPhys = runs[i].physical + (chn - runs[i].logical);
+      return true;
+    }
+  }
+  return false;
+}
+
+static void swmap_apply(const swmap_file_t *pFile) {
+  // looked up by the trigger and schedule ISRs
+  uint8_t sreg = SREG;
+  cli();
+  memcpy(map, pFile->runs, pFile->n * sizeof(map[0]));
+  mapRuns = pFile->n;
+  SREG = sreg;
+}
+
+void swmap_init(void) {
+  swmap_file_t file;
+  ConfigFile_Load(CONFIGFILE_SWMAP, &file, sizeof(file));
+  // erased EEPROM reads as 0xff
+  if (file.magic != SWMAP_MAGIC || file.n > SWMAP_MAX_RUNS)
+    file.n = 0;
+  swmap_apply(&file);
+}
+
+uint16_t swmap_physical(uint16_t chn) {
+  uint16_t phys;
+  if (chn < SWMAP_CHANNELS && swmap_lookup(map, mapRuns, chn, &phys))
+    return phys;
+  return chn;
+}
+
+// The new runs take precedence over the current map
+static uint16_t swmap_merged(const swmap_run_t *runs, uint8_t n,
+                             uint16_t chn) {
+  uint16_t phys;
+  if (swmap_lookup(runs, n, chn, &phys))
+    return phys;
+  return swmap_physical(chn);
+}
+
+static result_t swmap_save(const swmap_file_t *pFile) {
+  result_t ret = ConfigFile_Save(CONFIGFILE_SWMAP, pFile, sizeof(*pFile));
+  if (ret != RESULT_OK)
+    return ret;
+  swmap_apply(pFile);
+  return RESULT_OK;
+}
+
+static result_t swmap_build(const swmap_run_t *runs, uint8_t n,
+                            swmap_file_t *pFile) {
+  pFile->magic = SWMAP_MAGIC;
+  pFile->n = 0;
+  uint16_t chn = 0;
+  while (chn < SWMAP_CHANNELS) {
+    uint16_t first = chn;
+    uint16_t phys = swmap_merged(runs, n, chn);
+    while (++chn < SWMAP_CHANNELS &&
+           swmap_merged(runs, n, chn) == phys + (chn - first))
+      ;
+    if (phys == first)
+      continue;
+    if (pFile->n >= SWMAP_MAX_RUNS)
+      return S("Map doesn't fit 15 runs");
+    pFile->runs[pFile->n].logical = first;
+    pFile->runs[pFile->n].physical = phys;
+    pFile->runs[pFile->n].count = chn - first;
+    pFile->n++;
+  }
+  return RESULT_OK;
+}
+
+result_t swmap_check(const swmap_run_t *runs, uint8_t n) {
+  swmap_file_t file;
+  return swmap_build(runs, n, &file);
+}
+
+result_t swmap_write(const swmap_run_t *runs, uint8_t n) {
+  swmap_file_t file;
+  result_t ret = swmap_build(runs, n, &file);
+  if (ret != RESULT_OK)
+    return ret;
+  return swmap_save(&file);
+}
+
+result_t swmap_clear(void) {
+  swmap_file_t file;
+  memset(&file, 0xff, sizeof(file));
+  file.magic = SWMAP_MAGIC;
+  file.n = 0;
+  return swmap_save(&file);
+}
+
+result_t swmap_parse(const char **pArgs, swmap_run_t *runs, uint8_t *pN) {
+  const char *args = skipSpaces(*pArgs);
+  uint16_t channels = swgeometry_channels();
+  uint8_t n = 0;
+  if (!*args)
+    return S("Expected runs, e.g. 0-63:448,64:0");
+  for (;;) {
+    int32_t first, last, phys;
+    result_t ret = parseInt(&args, 0, SWMAP_CHANNELS - 1, &first);
+    if (ret != RESULT_OK)
+      return ret;
+    last = first;
+    if (*args == '-') {
+      args++;
+      ret = parseInt(&args, first, SWMAP_CHANNELS - 1, &last);
+      if (ret != RESULT_OK)
+        return ret;
+    }
+    if (*args != ':')
+      return S("Expected ':' and physical channel");
+    args++;
+    ret = parseInt(&args, 0, channels - 1 - (last - first), &phys);
+    if (ret != RESULT_OK)
+      return ret;
+    if (n >= *pN)
+      return S("Too many runs");
+    runs[n].logical = first;
+    runs[n].physical = phys;
+    runs[n].count = last - first + 1;
+    n++;
+    args = skipSpaces(args);
+    if (*args != ',')
+      break;
+    args++;
+  }
+  *pArgs = args;
+  *pN = n;
+  return RESULT_OK;
+}
+
+//******************************************************************************
+// user interface
+//******************************************************************************
+
+DEFINE_COMMAND(ROOT_MATRIX_MAP, SET, NULL, pObj, args, pOut) {
+  swmap_run_t runs[SWMAP_MAX_RUNS];
+  uint8_t n = SWMAP_MAX_RUNS;
+  result_t ret = swmap_parse(&args, runs, &n);
+  if (ret != RESULT_OK)
+    return ret;
+  if (*skipSpaces(args))
+    return S("Expected ',' or end of line");
+  return swmatrix_set_map(runs, n);
+}
+
+DEFINE_COMMAND(ROOT_MATRIX_MAP, CLEAR, NULL, pObj, args, pOut) {
+  return swmatrix_set_map(NULL, 0);
+}
+
+// Runs in the MATRIX.MAP.SET syntax, so the output can be uploaded again
+DEFINE_COMMAND(ROOT_MATRIX_MAP, DUMP, NULL, pObj, args, pOut) {
+  uint16_t chn = 0;
+  uint16_t runs = 0;
+  while (chn < SWMAP_CHANNELS) {
+    uint16_t first = chn;
+    uint16_t phys = swmap_physical(chn);
+    while (++chn < SWMAP_CHANNELS &&
+           swmap_physical(chn) == phys + (chn - first))
+      ;
+    if (runs % SWMAP_DUMP_RUNS)
+      CLI_TPRINTF_ASSERT(",");
+    else if (runs)
+      CLI_TPRINTF_ASSERT("\n");
+    if (chn - first > 1)
+      CLI_TPRINTF_ASSERT("%u-%u:%u", first, chn - 1, phys);
+    else
+      CLI_TPRINTF_ASSERT("%u:%u", first, phys);
+    runs++;
+  }
+  return RESULT_OK;
+}
+
+DEFINE_COMMAND(ROOT_MATRIX_MAP, GET, NULL, pObj, args, pOut) {
+  int32_t chn;
+  result_t ret = parseInt(&args, 0, SWMAP_CHANNELS - 1, &chn);
+  if (ret != RESULT_OK)
+    return S("Expected logical channel");
+  return CLI_TPRINTF("%u", swmap_physical(chn));
+}
+
+DEFINE_COMMAND_ARRAY(ROOT_MATRIX, MAP, GET);
@@ -0,0 +1,57 @@
+/**
+ *  \file
+ *
+ *  \brief Logical to physical channel map header file.
+ *
+ *  The channels of all commands, the sequencer, trigger and the UI are
+ *  logical (probe card pad) numbers. They are translated to the physical
+ *  matrix channels when the multiplexer address and chain position are
+ *  looked up, see swchnmap.h. The map is kept as a short list of runs,
+ *  in EEPROM and in RAM, channels outside the runs map to themselves.
+ */
+
+#ifndef _SWMAP_H__
+#define _SWMAP_H__
+
+#include "app_cfg.h"
+#include "types.h"
+
+/// Number of logical channels.
+#define SWMAP_CHANNELS 512
+
+/// Runs the stored map can hold, after merging adjacent ones.
+#define SWMAP_MAX_RUNS 15
+
+/// Consecutive logical channels mapped to consecutive physical ones.
+typedef struct {
+  uint16_t logical;
+  uint16_t physical;
+  uint16_t count;
+} swmap_run_t;
+
+/// Load the map from EEPROM, an invalid one maps all channels to themselves.
+void swmap_init(void);
+
+/// Physical channel of a logical one.
+uint16_t swmap_physical(uint16_t chn);
+
+/// Check that swmap_write() would accept the runs, nothing is written.
+result_t swmap_check(const swmap_run_t *runs, uint8_t n);
+
+/** \brief Write runs into the map, the other entries are kept.
+ *
+ *  Fails without changing the map if the result doesn't fit
+ *  SWMAP_MAX_RUNS runs.
+ */
+result_t swmap_write(const swmap_run_t *runs, uint8_t n);
+
+/// Map all channels to themselves.
+result_t swmap_clear(void);
+
+/** \brief Parse runs like "0-63:448,64:0".
+ *
+ *  \param[in,out] pN  Size of runs on entry, number of parsed runs on exit.
+ */
+result_t swmap_parse(const char **pArgs, swmap_run_t *runs, uint8_t *pN);
+
+#endif // !_SWMAP_H__
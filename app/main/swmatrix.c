@@ -12,18 +12,44 @@
 #include "cli.h"
 #include "cmdarg.h"
 #include "debug.h"
+#include "envmon.h"
+#include "interlock.h"
+#include "mt.h"
+#include "pins.h"
+#include "swchain.h"
+#include "sequencer.h"
+#include "swchnmap.h"
+#include "swcounter.h"
+#include "swgeometry.h"
+#include "swsched.h"
+#include "swsettle.h"
+#include "swmatrix_task.h"
+#include "timebase.h"
+#include "trigger.h"
+#include "trigout.h"
+#include <string.h>
 
 void swmatrix_switches_all_shorted();
 void led_display_update(void);
 void ui_set_value(uint16_t val);
+result_t ui_request_value(uint16_t val);
+void ui_show_value(uint16_t val);
 uint16_t ui_get_value(void);
 
 swmatrix_mode_t mode;
 swmatrix_meas_t meas;
 swmatrix_cvres_t cvres;
+static swmatrix_transition_t transition = SWMATRIX_TRANSITION_LEGACY;
+static uint16_t deadTime = SWMATRIX_DEFAULT_DEAD_TIME_US;
+static MT_SemType lock;
+static volatile bool preloadValid;
+static uint16_t preloadChn;
+static uint32_t shortTicks;
 
 static IMMUTABLE_STR(iv) = "IV";
 static IMMUTABLE_STR(cv) = "CV";
+static IMMUTABLE_STR(legacy) = "LEGACY";
+static IMMUTABLE_STR(single) = "SINGLE";
 static IMMUTABLE_STR(CVRES_100K) = "100K";
 static IMMUTABLE_STR(CVRES_500K) = "500K";
 static IMMUTABLE_STR(CVRES_1M) = "1M";
@@ -33,8 +59,13 @@ static IMMUTABLE_STR(CVRES_10M) = "10M";
 static IMMUTABLE_STR(CVRES_50M) = "50M";
 static IMMUTABLE_STR(CVRES_100M) = "100M";
 
-static twi_iface_t i2cMatrix = {0x80, 0x40};
-static twi_iface_t i2cProbeCard = {0x08, 0x04};
+// indexed by swmatrix_cvres_t value
+static const immutable_str cvresNames[8] IMMUTABLE_MEM = {
+    CVRES_100K, CVRES_5M,  CVRES_1M,  CVRES_50M,
+    CVRES_500K, CVRES_10M, CVRES_2M,  CVRES_100M};
+
+// two chain shifts of the legacy transition plus the dead time
+#define SWMATRIX_SELECT_TIMEOUT_TICKS (2 * OS_TICKS_PER_SEC)
 
 result_t swmatrix_init(void) {
   OSTimeDlyHMSM(0, 0, 0, 200);
@@ -56,23 +87,39 @@ result_t swmatrix_init(void) {
   // CVM2 - CVM0
   PORTH.DIRSET = 0x07;
 
-  // sync 0
-  PORTD.OUTCLR = 0x10;
-
-  // switches reset
-  PORTD.OUTSET = 0x8; // reset is active (signal in inverted on the board)
-  PORTD.OUTSET = 0x8; // reset is active (signal in inverted on the board)
-  PORTD.OUTSET = 0x8; // reset is active (signal in inverted on the board)
-  volatile uint8_t i;
-  for (i = 0; i < 10; i++)
-    ;
-  PORTD.OUTCLR = 0x8; // reset is inactive (signal in inverted on the board)
+  result_t ret = swchain_init();
+  if (ret != RESULT_OK)
+    return ret;
+  swgeometry_init();
+  swsettle_init();
+  swmap_init();
+  timebase_init();
+  trigger_init();
+  trigout_init();
+  interlock_init();
+  // semaphores can't be created before the OS is initialized
+  if (OSRunning && !lock && !MT_SEM_INIT(lock, 1))
+    return S("swmatrix_init: Can't create semaphore");
+  ret = twi_init();
+  if (ret != RESULT_OK)
+    return ret;
+  ret = swcounter_init();
+  if (ret != RESULT_OK)
+    return ret;
   swmatrix_switches_all_shorted();
   swmatrix_set_meas(SWMATRIX_MEAS_CV);
   return RESULT_OK;
 }
 
 void swmatrix_set_meas(swmatrix_meas_t _meas) {
+  uint16_t arg = _meas;
+  result_t ret;
+  if (swmatrix_call(SWMATRIX_REQ_MEAS, &arg, NULL, &ret))
+    return;
+  swmatrix_set_meas_fast(_meas);
+}
+
+void swmatrix_set_meas_fast(swmatrix_meas_t _meas) {
   meas = _meas;
   if (meas == SWMATRIX_MEAS_CV) {
     PORTE.OUTSET = 0x02;
@@ -92,107 +139,316 @@ void swmatrix_toggle_meas() {
     swmatrix_set_meas(SWMATRIX_MEAS_CV);
 }
 
-void swmatrix_switches_send_byte(uint8_t b) {
-  for (uint8_t bit = 0; bit < 8; bit++) {
-    // there is an inverter on the board
-    if (b & 0x80)
-      PORTD.OUTCLR = 0x20;
-    else
-      PORTD.OUTSET = 0x20;
-    volatile uint8_t i;
-    for (i = 0; i < 30; i++)
-      ;
-    // clock 1
-    PORTD.OUTSET = 0x80;
-    PORTD.OUTSET = 0x80;
-    for (i = 0; i < 30; i++)
-      ;
-    b <<= 1;
-    // clock 0
-    PORTD.OUTCLR = 0x80;
-    for (i = 0; i < 30; i++)
-      ;
-  }
-}
-
 void swmatrix_switches_all_shorted() {
-  // clock 1
-  PORTD.OUTSET = 0x80;
-  PORTD.OUTSET = 0x80;
-  // sync 1
-  PORTD.OUTSET = 0x10;
-  // clock 0
-  PORTD.OUTCLR = 0x80;
-  PORTD.OUTCLR = 0x80;
-  PORTD.OUTCLR = 0x80;
-  PORTD.OUTCLR = 0x80;
-
-  // sync 0
-  PORTD.OUTCLR = 0x10;
-
-  for (uint8_t chip = 0; chip < 64; chip++)
-    swmatrix_switches_send_byte(0xFF);
-  // sync 1
-  PORTD.OUTSET = 0x10;
+  swchain_prepare_single(0, 0xff);
+  swchain_discard();
+  swchain_load();
+  swchain_latch();
 }
 
 void swmatrix_switches_open_one_channel(uint16_t chn) {
-  // clock 1
-  PORTD.OUTSET = 0x80;
-  PORTD.OUTSET = 0x80;
-  // sync 1
-  PORTD.OUTSET = 0x10;
-  // clock 0
-  PORTD.OUTCLR = 0x80;
-  PORTD.OUTCLR = 0x80;
-  PORTD.OUTCLR = 0x80;
-  PORTD.OUTCLR = 0x80;
-
-  // sync 0
-  PORTD.OUTCLR = 0x10;
-
-  uint8_t chnInChip = chn % 8;
-  uint8_t chipInRow = (chn / 8) % 8;
-  uint8_t row = (chn / 64) % 8;
-  uint8_t mapping[] = {3, 2, 1, 0, 7, 6, 5, 4};
-
-  for (int8_t r = 7; r >= 0; r--)
-    for (int8_t c = 0; c < 8; c++) // chip
-    {
-      uint8_t byte = 0xff;
-      if (row == r && c == chipInRow)
-        byte = ~(1 << (7 - mapping[chnInChip]));
-      swmatrix_switches_send_byte(byte);
-    }
-  // sync 1
-  PORTD.OUTSET = 0x10;
+  swchain_prepare_single(swchnmap_chain_byte(chn), ~swchnmap_chain_mask(chn));
+  swchain_discard();
+  swchain_load();
+  swchain_latch();
 }
 
-void swmatrix_select_channel(uint16_t chn) {
-  uint16_t chnraw = chn;
+void swmatrix_set_address(uint16_t chn) {
+  PORTC.OUT = swchnmap_addr_lo(chn);
+  if (swchnmap_addr_hi(chn))
+    PINS_SET(CHAIN, 0x01);
+  else
+    PINS_CLR(CHAIN, 0x01);
+}
+
+// Whole OS ticks of the dead time are slept, as in swsettle_wait(), only
+// the rest is busy-waited
+static void swmatrix_dead_time_wait(void) {
+  uint32_t since = timebase_now();
+  uint16_t ticks = deadTime / (1000000UL / OS_TICKS_PER_SEC);
+  // a delay of n ticks lasts between n - 1 and n tick periods
+  if (ticks > 1)
+    OSTimeDly(ticks - 1);
+  uint32_t wait = timebase_us_to_ticks(deadTime);
+  while (timebase_now() - since < wait)
+    ;
+}
+
+static void swmatrix_select_channel_legacy(uint16_t chn) {
   swmatrix_switches_all_shorted();
   if (chn != 0xffff) {
-    uint8_t a6a7a8 = (chn >> 6) & 0x7;
-    chn &= ~(0x100 | 0x080 | 0x040);
-    uint8_t a6a7a8_map[] = {4, 5, 6, 7, 3, 2, 1, 0};
-    uint8_t a6a7a8_mapped = a6a7a8_map[a6a7a8];
-    chn |= ((uint16_t)a6a7a8_mapped) << 6;
-
-    uint8_t a0a1a2 = (chn)&0x7;
-    chn &= ~(0x1 | 0x02 | 0x4);
-    uint8_t a0a1a2_map[] = {3, 2, 1, 0, 4, 5, 6, 7};
-    uint8_t a0a1a2_mapped = a0a1a2_map[a0a1a2];
-    chn |= ((uint16_t)a0a1a2_mapped);
-
-    PORTC.OUT = chn & 0xff;
-    if (chn & 0x100)
-      PORTD.OUTSET = 0x01;
+    swmatrix_set_address(chn);
+    swmatrix_switches_open_one_channel(chn);
+  }
+}
+
+static void swmatrix_select_channel_single(uint16_t chn) {
+  if (chn == 0xffff) {
+    swmatrix_switches_all_shorted();
+    return;
+  }
+  // The previous channel gets shorted with the same SYNC edge which opens
+  // the new one. The multiplexer still points to the (now shorted)
+  // previous channel and is moved only after the dead time, so the
+  // measurement path breaks before it makes.
+  swmatrix_switches_open_one_channel(chn);
+  swmatrix_dead_time_wait();
+  swmatrix_set_address(chn);
+}
+
+void swmatrix_lock(void) {
+  if (lock)
+    MT_SEM_PEND(lock, 0);
+}
+
+void swmatrix_unlock(void) {
+  if (lock)
+    MT_SEM_POST(lock);
+}
+
+void swmatrix_select_channel(uint16_t chn) {
+  result_t ret;
+  if (swmatrix_call(SWMATRIX_REQ_SELECT, &chn, NULL, &ret))
+    return;
+  // the chain may be driven from the CLI, UI and sequencer tasks
+  // a tripped interlock keeps everything shorted
+  if (interlock_is_tripped())
+    chn = 0xffff;
+  swmatrix_lock();
+  // manual selection takes the chain over from the trigger
+  if (trigger_is_armed())
+    trigger_disarm();
+  swsched_cancel();
+  preloadValid = false;
+  if (transition == SWMATRIX_TRANSITION_SINGLE)
+    swmatrix_select_channel_single(chn);
+  else
+    swmatrix_select_channel_legacy(chn);
+  trigout_start(chn);
+  swmatrix_unlock();
+}
+
+result_t swmatrix_preload(uint16_t chn) {
+  result_t ret;
+  if (swmatrix_call(SWMATRIX_REQ_PRELOAD, &chn, NULL, &ret))
+    return ret;
+  if (interlock_is_tripped())
+    return S("Interlock tripped");
+  swmatrix_lock();
+  if (trigger_is_armed())
+    trigger_disarm();
+  swsched_cancel();
+  // the selected channel must not be shorted to drop an earlier preload
+  if (swchain_pending()) {
+    swmatrix_unlock();
+    return S("Frame pending, commit or select a channel first");
+  }
+  if (chn == 0xffff)
+    swchain_prepare_single(0, 0xff);
+  else
+    swchain_prepare_single(swchnmap_chain_byte(chn),
+                           ~swchnmap_chain_mask(chn));
+  swchain_load();
+  preloadChn = chn;
+  preloadValid = true;
+  swmatrix_unlock();
+  return RESULT_OK;
+}
+
+result_t swmatrix_commit(uint16_t *pChn) {
+  result_t ret = RESULT_OK;
+  uint16_t chn;
+  if (swmatrix_call(SWMATRIX_REQ_COMMIT, &chn, NULL, &ret)) {
+    if (pChn)
+      *pChn = chn;
+    return ret;
+  }
+  swmatrix_lock();
+  if (interlock_is_tripped()) {
+    preloadValid = false;
+    ret = S("Interlock tripped");
+  } else if (!preloadValid) {
+    ret = S("No channel preloaded");
+  } else {
+    preloadValid = false;
+    // break before make as in the single-shift transition
+    if (!swchain_latch()) {
+      swmatrix_unlock();
+      return S("Interlock tripped");
+    }
+    if (preloadChn != 0xffff) {
+      swmatrix_dead_time_wait();
+      swmatrix_set_address(preloadChn);
+    }
+    trigout_start(preloadChn);
+    if (pChn)
+      *pChn = preloadChn;
+  }
+  swmatrix_unlock();
+  return ret;
+}
+
+void swmatrix_cancel_preload(void) { preloadValid = false; }
+
+result_t swmatrix_apply_frame(const uint8_t *frame) {
+  result_t ret;
+  if (swmatrix_call(SWMATRIX_REQ_FRAME, NULL, frame, &ret))
+    return ret;
+  if (interlock_is_tripped())
+    return S("Interlock tripped");
+  swmatrix_lock();
+  if (trigger_is_armed())
+    trigger_disarm();
+  swsched_cancel();
+  preloadValid = false;
+  // several channels may be open, there's no single settle time
+  trigout_abort();
+  swchain_shift(frame);
+  swmatrix_unlock();
+  return RESULT_OK;
+}
+
+result_t swmatrix_change_channels(const uint8_t *list, bool open) {
+  result_t ret;
+  if (swmatrix_call(open ? SWMATRIX_REQ_OPEN : SWMATRIX_REQ_CLOSE, NULL, list,
+                    &ret))
+    return ret;
+  if (interlock_is_tripped())
+    return S("Interlock tripped");
+  swmatrix_lock();
+  if (trigger_is_armed())
+    trigger_disarm();
+  swsched_cancel();
+  preloadValid = false;
+  trigout_abort();
+  uint8_t frame[SWCHAIN_MAX_CHIPS];
+  swchain_get_image(frame);
+  for (uint16_t i = 0; i < swchain_get_chips(); i++) {
+    if (open)
+      frame[i] &= list[i];
     else
-      PORTD.OUTCLR = 0x01;
-    swmatrix_switches_open_one_channel(chnraw);
+      frame[i] |= ~list[i];
+  }
+  swchain_shift(frame);
+  swmatrix_unlock();
+  return RESULT_OK;
+}
+
+bool swmatrix_frame_is_open(const uint8_t *frame, uint16_t chn) {
+  return !(frame[swchnmap_chain_byte(chn)] & swchnmap_chain_mask(chn));
+}
+
+void swmatrix_frame_set_open(uint8_t *frame, uint16_t chn, bool open) {
+  if (open)
+    frame[swchnmap_chain_byte(chn)] &= ~swchnmap_chain_mask(chn);
+  else
+    frame[swchnmap_chain_byte(chn)] |= swchnmap_chain_mask(chn);
+}
+
+result_t swmatrix_parse_channel_list(const char **pArgs, uint8_t *frame,
+                                     bool open) {
+  const char *args = skipSpaces(*pArgs);
+  if (!*args)
+    return S("Expected channel list, e.g. 1,5,100-107");
+  for (;;) {
+    int32_t first, last;
+    result_t ret = parseInt(&args, 0, swgeometry_channels() - 1, &first);
+    if (ret != RESULT_OK)
+      return ret;
+    last = first;
+    if (*args == '-') {
+      args++;
+      ret = parseInt(&args, first, swgeometry_channels() - 1, &last);
+      if (ret != RESULT_OK)
+        return ret;
+    }
+    for (int32_t chn = first; chn <= last; chn++)
+      swmatrix_frame_set_open(frame, chn, open);
+    args = skipSpaces(args);
+    if (*args != ',')
+      break;
+    args++;
   }
+  *pArgs = args;
+  return RESULT_OK;
+}
+
+void swmatrix_short_all_fast(uint32_t requested) {
+  uint8_t sreg = SREG;
+  cli();
+  // stops the DMA first, or it would keep clocking bits in after the reset
+  bool wake = swchain_abort();
+  shortTicks = timebase_now() - requested;
+  trigger_abort();
+  swsched_abort();
+  trigout_abort();
+  SREG = sreg;
+  // the task loading the chain sees the frame discarded
+  if (wake)
+    swchain_wake();
+  preloadValid = false;
+  sequencer_abort();
+  swmatrix_cancel_async();
+}
+
+result_t swmatrix_set_geometry(const swgeometry_t *pGeometry) {
+  swmatrix_lock();
+  if (trigger_is_armed())
+    trigger_disarm();
+  swsched_cancel();
+  // the steps and the preload refer to channels of the old geometry
+  sequencer_abort();
+  preloadValid = false;
+  result_t ret = swgeometry_set(pGeometry);
+  swmatrix_unlock();
+  // a rejected geometry leaves the chain as it was
+  if (ret != RESULT_OK)
+    return ret;
+  // the chain is reset by the change, make sure it's fully shorted
+  swmatrix_select_channel(0xffff);
+  ui_show_value(0xffff);
+  return ret;
+}
+
+result_t swmatrix_set_map(const swmap_run_t *runs, uint8_t n) {
+  // a map which can't be written leaves everything running
+  result_t ret = n ? swmap_check(runs, n) : RESULT_OK;
+  if (ret != RESULT_OK)
+    return ret;
+  swmatrix_lock();
+  if (trigger_is_armed())
+    trigger_disarm();
+  swsched_cancel();
+  // the steps and the preload refer to channels of the old map
+  sequencer_abort();
+  preloadValid = false;
+  ret = n ? swmap_write(runs, n) : swmap_clear();
+  swmatrix_unlock();
+  swmatrix_select_channel(0xffff);
+  ui_show_value(0xffff);
+  return ret;
+}
+
+uint32_t swmatrix_get_short_time_ns(void) {
+  uint32_t ticks;
+  MT_ATOMIC_EXPR(ticks = shortTicks);
+  return timebase_ticks_to_ns(ticks);
 }
 
+uint16_t swmatrix_get_preloaded(void) {
+  return preloadValid ? preloadChn : SWMATRIX_NO_PRELOAD;
+}
+
+swmatrix_transition_t swmatrix_get_transition(void) { return transition; }
+
+void swmatrix_set_transition(swmatrix_transition_t _transition) {
+  transition = _transition;
+}
+
+uint16_t swmatrix_get_dead_time(void) { return deadTime; }
+
+void swmatrix_set_dead_time(uint16_t us) { deadTime = us; }
+
 swmatrix_mode_t swmatrix_get_mode() { return mode; }
 
 void swmatrix_set_mode(swmatrix_mode_t _mode) { mode = _mode; }
@@ -200,37 +456,261 @@ void swmatrix_set_mode(swmatrix_mode_t _mode) { mode = _mode; }
 swmatrix_cvres_t swmatrix_get_cvres(void) { return cvres; }
 
 void swmatrix_set_cvres(swmatrix_cvres_t cvres_) {
+  uint16_t arg = cvres_;
+  result_t ret;
+  if (swmatrix_call(SWMATRIX_REQ_CVRES, &arg, NULL, &ret))
+    return;
   cvres = cvres_;
   PORTH.OUTCLR = 0x07;
   PORTH.OUTSET = cvres & 0x07;
 }
 
+immutable_str swmatrix_meas_name(swmatrix_meas_t _meas) {
+  return _meas == SWMATRIX_MEAS_CV ? cv : iv;
+}
+
+immutable_str swmatrix_cvres_name(swmatrix_cvres_t _cvres) {
+  return READ_IMMUTABLE_PTR(&cvresNames[_cvres & 0x07]);
+}
+
+result_t swmatrix_parse_meas(const char **pArgs, swmatrix_meas_t *pMeas) {
+  char buf[3];
+  if (parseString(pArgs, sizeof(buf), buf) != RESULT_OK)
+    return S("Expected IV or CV");
+  if (stricmp_P(buf, iv) == 0)
+    *pMeas = SWMATRIX_MEAS_IV;
+  else if (stricmp_P(buf, cv) == 0)
+    *pMeas = SWMATRIX_MEAS_CV;
+  else
+    return S("Expected IV or CV");
+  return RESULT_OK;
+}
+
+result_t swmatrix_parse_cvres(const char **pArgs, swmatrix_cvres_t *pCvres) {
+  char buf[5];
+  if (parseString(pArgs, sizeof(buf), buf) == RESULT_OK) {
+    for (uint8_t i = 0; i < 8; i++) {
+      if (stricmp_P(buf, swmatrix_cvres_name(i)) == 0) {
+        *pCvres = i;
+        return RESULT_OK;
+      }
+    }
+  }
+  return S("Expected 100K, 500K, 1M, 2M, 5M, 10M, 50M, 100M");
+}
+
 //******************************************************************************
 // user interface
 //******************************************************************************
 
 DEFINE_COMMAND(ROOT_MATRIX, SHORTALL, NULL, pObj, args, pOut) {
-  swmatrix_switches_all_shorted();
-  ui_set_value(0xffff);
+  swmatrix_short_all_fast(timebase_now());
+  ui_show_value(0xffff);
+  return RESULT_OK;
+}
+
+DEFINE_COMMAND(ROOT_MATRIX, SHORTTIME, NULL, pObj, args, pOut) {
+  return CLI_TPRINTF("%lu", swmatrix_get_short_time_ns());
+}
+
+DEFINE_COMMAND(ROOT_MATRIX, SHIFTRATE, NULL, pObj, args, pOut) {
+  args = skipSpaces(args);
+  // get request
+  if (strlen(args) == 0 || strcmp_P(args, S("?")) == 0)
+    return CLI_TPRINTF("%lu", swchain_get_bit_period());
+  // set request
+  int32_t val;
+  result_t ret = parseInt(&args, SWCHAIN_MIN_BIT_PERIOD_NS,
+                          SWCHAIN_MAX_BIT_PERIOD_NS, &val);
+  if (ret != RESULT_OK)
+    return ret;
+  return swchain_set_bit_period(val);
+}
+
+DEFINE_COMMAND(ROOT_MATRIX, TRANSITION, NULL, pObj, args, pOut) {
+  args = skipSpaces(args);
+  // get request
+  if (strlen(args) == 0 || strcmp_P(args, S("?")) == 0) {
+    if (swmatrix_get_transition() == SWMATRIX_TRANSITION_SINGLE)
+      CLI_TPRINTFI_ASSERT(single);
+    else
+      CLI_TPRINTFI_ASSERT(legacy);
+    return RESULT_OK;
+  }
+  // set request
+  else if (stricmp_P(args, legacy) == 0) {
+    swmatrix_set_transition(SWMATRIX_TRANSITION_LEGACY);
+    return RESULT_OK;
+  } else if (stricmp_P(args, single) == 0) {
+    swmatrix_set_transition(SWMATRIX_TRANSITION_SINGLE);
+    return RESULT_OK;
+  } else
+    return S("Expected LEGACY or SINGLE");
+}
+
+DEFINE_COMMAND(ROOT_MATRIX, DEADTIME, NULL, pObj, args, pOut) {
+  args = skipSpaces(args);
+  // get request
+  if (strlen(args) == 0 || strcmp_P(args, S("?")) == 0)
+    return CLI_TPRINTF("%u", swmatrix_get_dead_time());
+  // set request
+  int32_t val;
+  result_t ret = parseInt(&args, 0, SWMATRIX_MAX_DEAD_TIME_US, &val);
+  if (ret != RESULT_OK)
+    return ret;
+  swmatrix_set_dead_time(val);
   return RESULT_OK;
 }
 
+DEFINE_COMMAND(ROOT_MATRIX, PRELOAD, NULL, pObj, args, pOut) {
+  args = skipSpaces(args);
+  // get request
+  if (strlen(args) == 0 || strcmp_P(args, S("?")) == 0) {
+    uint16_t chn = swmatrix_get_preloaded();
+    if (chn == SWMATRIX_NO_PRELOAD)
+      return CLI_TPRINTF("---");
+    return CLI_TPRINTF("%u", chn);
+  }
+  // set request
+  int32_t val;
+  result_t ret = parseInt(&args, 0, swgeometry_channels() - 1, &val);
+  if (ret != RESULT_OK)
+    return ret;
+  return swmatrix_preload(val);
+}
+
+DEFINE_COMMAND(ROOT_MATRIX, COMMIT, NULL, pObj, args, pOut) {
+  uint16_t chn;
+  result_t ret = swmatrix_commit(&chn);
+  if (ret != RESULT_OK)
+    return ret;
+  ui_show_value(chn);
+  return RESULT_OK;
+}
+
+static result_t swmatrix_print_open(uint8_t *frame, void *pOut) {
+  swchain_get_image(frame);
+  uint16_t channels = swgeometry_channels();
+  bool any = false;
+  for (uint16_t chn = 0; chn < channels; chn++) {
+    if (!swmatrix_frame_is_open(frame, chn))
+      continue;
+    uint16_t last = chn;
+    while (last + 1 < channels && swmatrix_frame_is_open(frame, last + 1))
+      last++;
+    if (any)
+      CLI_TPRINTF_ASSERT(",");
+    if (last == chn)
+      CLI_TPRINTF_ASSERT("%u", chn);
+    else
+      CLI_TPRINTF_ASSERT("%u-%u", chn, last);
+    any = true;
+    chn = last;
+  }
+  if (!any)
+    CLI_TPRINTF_ASSERT("---");
+  return RESULT_OK;
+}
+
+static result_t swmatrix_open_close(const char *args, void *pOut, bool open) {
+  uint8_t frame[SWCHAIN_MAX_CHIPS];
+  args = skipSpaces(args);
+  // get request
+  if (strlen(args) == 0 || strcmp_P(args, S("?")) == 0)
+    return swmatrix_print_open(frame, pOut);
+  // set request, nothing is switched unless the whole list is valid
+  memset(frame, 0xff, sizeof(frame));
+  result_t ret = swmatrix_parse_channel_list(&args, frame, true);
+  if (ret != RESULT_OK)
+    return ret;
+  if (*skipSpaces(args))
+    return S("Expected channel list, e.g. 1,5,100-107");
+  ret = swmatrix_change_channels(frame, open);
+  if (ret != RESULT_OK)
+    return ret;
+  // the display can't show a set of channels, but it can show none
+  swchain_get_image(frame);
+  for (uint16_t i = 0; i < swchain_get_chips(); i++)
+    if (frame[i] != 0xff)
+      return RESULT_OK;
+  ui_show_value(0xffff);
+  return RESULT_OK;
+}
+
+DEFINE_COMMAND(ROOT_MATRIX, OPEN, NULL, pObj, args, pOut) {
+  return swmatrix_open_close(args, pOut, true);
+}
+
+DEFINE_COMMAND(ROOT_MATRIX, CLOSE, NULL, pObj, args, pOut) {
+  return swmatrix_open_close(args, pOut, false);
+}
+
+DEFINE_COMMAND(ROOT_MATRIX, GEOMETRY, NULL, pObj, args, pOut) {
+  args = skipSpaces(args);
+  swgeometry_t geometry;
+  // get request
+  if (strlen(args) == 0 || strcmp_P(args, S("?")) == 0) {
+    swgeometry_get(&geometry);
+    return CLI_TPRINTF("%u %u %u", geometry.chips, geometry.rowChips,
+                       geometry.addrBits);
+  }
+  // set request
+  int32_t chips, rowChips, addrBits;
+  result_t ret = parseInt(&args, 1, SWCHAIN_MAX_CHIPS, &chips);
+  if (ret != RESULT_OK)
+    return ret;
+  ret = parseInt(&args, 1, SWCHAIN_MAX_CHIPS, &rowChips);
+  if (ret != RESULT_OK)
+    return ret;
+  ret = parseInt(&args, 1, SWGEOMETRY_MAX_ADDR_BITS, &addrBits);
+  if (ret != RESULT_OK)
+    return ret;
+  geometry.chips = chips;
+  geometry.rowChips = rowChips;
+  geometry.addrBits = addrBits;
+  ret = swmatrix_set_geometry(&geometry);
+  if (ret != RESULT_OK)
+    return ret;
+  return swgeometry_save();
+}
+
 DEFINE_COMMAND(ROOT_MATRIX, CHANNEL, NULL, pObj, args, pOut) {
   args = skipSpaces(args);
   if (strlen(args) == 0 || strcmp_P(args, S("?")) == 0) {
     if (ui_get_value() == 0xFFFF)
       CLI_TPRINTF_ASSERT("---");
     else {
-      int16_t val = ui_get_value();
-      val = val & 0xfff;
-      CLI_TPRINTF_ASSERT("%d", val);
+      CLI_TPRINTF_ASSERT("%u", ui_get_value());
     }
   } else { // set dac
     int32_t val;
-    result_t ret = parseInt(&args, 0, 511, &val);
+    result_t ret = parseInt(&args, 0, swgeometry_channels() - 1, &val);
+    if (ret != RESULT_OK)
+      return ret;
+    uint32_t due;
+    bool scheduled;
+    ret = swsched_parse_time(&args, &due, &scheduled);
+    if (ret != RESULT_OK)
+      return ret;
+    args = skipSpaces(args);
+    bool async = false;
+    if (stricmp_P(args, S("ASYNC")) == 0)
+      async = true;
+    else if (*args)
+      return S("Expected AT, IN, ASYNC or nothing");
+    if (interlock_is_tripped())
+      return S("Interlock tripped");
+    // the display is updated by the UI task once the channel is selected
+    if (scheduled)
+      return swsched_add(SWSCHED_CHANNEL, val, due);
+    ret = ui_request_value(val);
+    if (ret != RESULT_OK || async)
+      return ret;
+    ret = swmatrix_wait_selected(SWMATRIX_SELECT_TIMEOUT_TICKS);
     if (ret != RESULT_OK)
       return ret;
-    ui_set_value(val);
+    // report completion once the channel can be measured
+    swsettle_wait(val, timebase_now());
   }
   return RESULT_OK;
 }
@@ -246,78 +726,38 @@ DEFINE_COMMAND(ROOT_MATRIX, MEASUREMENT, NULL, pObj, args, pOut) {
     return RESULT_OK;
   }
   // set request
-  else if (stricmp_P(args, iv) == 0) {
-    swmatrix_set_meas(SWMATRIX_MEAS_IV);
-    led_display_update();
-    return RESULT_OK;
-  } else if (stricmp_P(args, cv) == 0) {
-    swmatrix_set_meas(SWMATRIX_MEAS_CV);
-    led_display_update();
-    return RESULT_OK;
-  } else
-    return S("Expected IV or CV");
+  swmatrix_meas_t m;
+  result_t ret = swmatrix_parse_meas(&args, &m);
+  if (ret != RESULT_OK)
+    return ret;
+  uint32_t due;
+  bool scheduled;
+  ret = swsched_parse_time(&args, &due, &scheduled);
+  if (ret != RESULT_OK)
+    return ret;
+  if (*skipSpaces(args))
+    return S("Expected AT, IN or nothing");
+  if (scheduled)
+    return swsched_add(SWSCHED_MEAS, m, due);
+  swmatrix_set_meas(m);
+  led_display_update();
+  return RESULT_OK;
 }
 
 DEFINE_COMMAND(ROOT_MATRIX, CVRES, NULL, pObj, args, pOut) {
   args = skipSpaces(args);
   // get request
-  if (strlen(args) == 0 || strcmp_P(args, S("?")) == 0) {
-    swmatrix_cvres_t res = swmatrix_get_cvres();
-    switch (res) {
-    case SWMATRIX_CVRES_100K:
-      CLI_TPRINTFI_ASSERT(CVRES_100K);
-      break;
-    case SWMATRIX_CVRES_500K:
-      CLI_TPRINTFI_ASSERT(CVRES_500K);
-      break;
-    case SWMATRIX_CVRES_1M:
-      CLI_TPRINTFI_ASSERT(CVRES_1M);
-      break;
-    case SWMATRIX_CVRES_2M:
-      CLI_TPRINTFI_ASSERT(CVRES_2M);
-      break;
-    case SWMATRIX_CVRES_5M:
-      CLI_TPRINTFI_ASSERT(CVRES_5M);
-      break;
-    case SWMATRIX_CVRES_10M:
-      CLI_TPRINTFI_ASSERT(CVRES_10M);
-      break;
-    case SWMATRIX_CVRES_50M:
-      CLI_TPRINTFI_ASSERT(CVRES_50M);
-      break;
-    case SWMATRIX_CVRES_100M:
-      CLI_TPRINTFI_ASSERT(CVRES_100M);
-      break;
-    }
-    return RESULT_OK;
-  }
+  if (strlen(args) == 0 || strcmp_P(args, S("?")) == 0)
+    return CLI_TPRINTFI(swmatrix_cvres_name(swmatrix_get_cvres()));
   // set request
-  else if (stricmp_P(args, CVRES_100K) == 0) {
-    swmatrix_set_cvres(SWMATRIX_CVRES_100K);
-    return RESULT_OK;
-  } else if (stricmp_P(args, CVRES_500K) == 0) {
-    swmatrix_set_cvres(SWMATRIX_CVRES_500K);
-    return RESULT_OK;
-  } else if (stricmp_P(args, CVRES_1M) == 0) {
-    swmatrix_set_cvres(SWMATRIX_CVRES_1M);
-    return RESULT_OK;
-  } else if (stricmp_P(args, CVRES_2M) == 0) {
-    swmatrix_set_cvres(SWMATRIX_CVRES_2M);
-    return RESULT_OK;
-  } else if (stricmp_P(args, CVRES_5M) == 0) {
-    swmatrix_set_cvres(SWMATRIX_CVRES_5M);
-    return RESULT_OK;
-  } else if (stricmp_P(args, CVRES_10M) == 0) {
-    swmatrix_set_cvres(SWMATRIX_CVRES_10M);
-    return RESULT_OK;
-  } else if (stricmp_P(args, CVRES_50M) == 0) {
-    swmatrix_set_cvres(SWMATRIX_CVRES_50M);
-    return RESULT_OK;
-  } else if (stricmp_P(args, CVRES_100M) == 0) {
-    swmatrix_set_cvres(SWMATRIX_CVRES_100M);
-    return RESULT_OK;
-  } else
+  swmatrix_cvres_t res;
+  result_t ret = swmatrix_parse_cvres(&args, &res);
+  if (ret != RESULT_OK)
+    return ret;
+  if (*skipSpaces(args))
     return S("Expected 100K, 500K, 1M, 2M, 5M, 10M, 50M, 100M");
+  swmatrix_set_cvres(res);
+  return RESULT_OK;
 }
 
 DEFINE_COMMAND(ROOT_MATRIX, INFO, NULL, pObj, args, pOut) {
@@ -326,52 +766,53 @@ DEFINE_COMMAND(ROOT_MATRIX, INFO, NULL, pObj, args, pOut) {
   return RESULT_OK;
 }
 
-result_t getI2Ctemp(twi_iface_t *iface, void *pOut) {
-  unsigned char data[4];
-  char err = 0;
-  twi_init(iface);
-  data[0] = 0xe3; // Trigger T measurement hold master
-  err = twi_write_data(iface, 0x40, data, 1);
-  err = twi_read_data(iface, 0x40, data, 3);
-  uint16_t st = data[0];
-  st <<= 8;
-  st |= data[1];
-  float temp = -46.85 + 0.0026812744140625 * st;
-  if (err)
+// Reading of a sensor, at most [max age in ms] old. The readings refreshed by
+// the monitor task are used if no age is given.
+static result_t swmatrix_env_get(envmon_sensor_t sensor,
+                                 envmon_quantity_t quantity, const char *args,
+                                 uint16_t *pRaw) {
+  uint32_t maxAge = ENVMON_ANY_AGE;
+  args = skipSpaces(args);
+  if (strlen(args) != 0 && strcmp_P(args, S("?")) != 0) {
+    int32_t ms;
+    result_t ret = parseInt(&args, 0, INT32_MAX, &ms);
+    if (ret != RESULT_OK)
+      return ret;
+    maxAge = ms;
+  }
+  return envmon_get(sensor, quantity, maxAge, pRaw);
+}
+
+static result_t getI2Ctemp(envmon_sensor_t sensor, const char *args,
+                           void *pOut) {
+  uint16_t st;
+  if (swmatrix_env_get(sensor, ENVMON_TEMPERATURE, args, &st) != RESULT_OK)
     return CLI_TPRINTF("Error");
-  return CLI_TPRINTF("%.4f", temp);
-}
-
-result_t getI2Chumidity(twi_iface_t *iface, void *pOut) {
-  unsigned char data[4];
-  char err = 0;
-  twi_init(iface);
-  data[0] = 0xe5; // Trigger T measurement hold master
-  err = twi_write_data(iface, 0x40, data, 1);
-  err = twi_read_data(iface, 0x40, data, 3);
-  uint16_t rh = data[0];
-  rh <<= 8;
-  rh |= data[1];
-  float relhum = -6 + 0.0019073486328125 * rh;
-  if (err)
+  return CLI_TPRINTF("%.3lk", envmon_to_milli(ENVMON_TEMPERATURE, st));
+}
+
+static result_t getI2Chumidity(envmon_sensor_t sensor, const char *args,
+                               void *pOut) {
+  uint16_t rh;
+  if (swmatrix_env_get(sensor, ENVMON_HUMIDITY, args, &rh) != RESULT_OK)
     return CLI_TPRINTF("Error");
-  return CLI_TPRINTF("%.4f", relhum);
+  return CLI_TPRINTF("%.3lk", envmon_to_milli(ENVMON_HUMIDITY, rh));
 }
 
 DEFINE_COMMAND(ROOT_MATRIX, TEMPERATURE, NULL, pObj, args, pOut) {
-  return getI2Ctemp(&i2cMatrix, pOut);
+  return getI2Ctemp(ENVMON_MATRIX, args, pOut);
 }
 
 DEFINE_COMMAND(ROOT_MATRIX, HUMIDITY, NULL, pObj, args, pOut) {
-  return getI2Chumidity(&i2cMatrix, pOut);
+  return getI2Chumidity(ENVMON_MATRIX, args, pOut);
 }
 
 DEFINE_COMMAND(ROOT_PROBECARD, TEMPERATURE, NULL, pObj, args, pOut) {
-  return getI2Ctemp(&i2cProbeCard, pOut);
+  return getI2Ctemp(ENVMON_PROBECARD, args, pOut);
 }
 
 DEFINE_COMMAND(ROOT_PROBECARD, HUMIDITY, NULL, pObj, args, pOut) {
-  return getI2Chumidity(&i2cProbeCard, pOut);
+  return getI2Chumidity(ENVMON_PROBECARD, args, pOut);
 }
 DEFINE_COMMAND(ROOT_PROBECARD, INFO, NULL, pObj, args, pOut) {
   CLI_TPRINTF_ASSERT("Probecard related commands.");
@@ -2,6 +2,8 @@
 #define __SWMATRIX_H__
 #include "command.h"
 #include "stream.h"
+#include "swgeometry.h"
+#include "swmap.h"
 #include "terminal.h"
 #include "types.h"
 #include "ucos_ii.h"
@@ -16,6 +18,16 @@ typedef enum swmatrix_meas_enum {
   SWMATRIX_MEAS_CV = 1
 } swmatrix_meas_t;
 
+typedef enum swmatrix_transition_enum {
+  // short all switches, then open the selected one (two chain shifts)
+  SWMATRIX_TRANSITION_LEGACY = 0,
+  // one chain shift, multiplexer moved after the dead time
+  SWMATRIX_TRANSITION_SINGLE = 1
+} swmatrix_transition_t;
+
+#define SWMATRIX_DEFAULT_DEAD_TIME_US 10
+#define SWMATRIX_MAX_DEAD_TIME_US 10000
+
 /* this is how it should be
 typedef enum swmatrix_cvres
 {
@@ -51,9 +63,119 @@ swmatrix_meas_t swmatrix_get_meas(void);
 void swmatrix_set_meas(swmatrix_meas_t meas);
 void swmatrix_toggle_meas(void);
 
+/** \brief Switch the measurement relays, bypassing the matrix task.
+ *
+ *  \note May be called from an ISR.
+ */
+void swmatrix_set_meas_fast(swmatrix_meas_t meas);
+
 void swmatrix_select_channel(uint16_t chn);
 
+/** \brief Set the multiplexer address (PORTC, PD0) of a channel.
+ *
+ *  \note May be called from an ISR.
+ */
+void swmatrix_set_address(uint16_t chn);
+
+#define SWMATRIX_NO_PRELOAD 0xfffe
+
+/** \brief Shift the frame of a channel into the chain without latching it.
+ *
+ *  The currently selected channel stays selected until swmatrix_commit().
+ *
+ *  \param[in]  chn  Channel or 0xffff for all switches shorted.
+ */
+result_t swmatrix_preload(uint16_t chn);
+
+/** \brief Latch the preloaded channel and move the mux to it.
+ *
+ *  The mux moves after the dead time, as in the single-shift transition.
+ *
+ *  \param[out] pChn  Committed channel, may be NULL.
+ */
+result_t swmatrix_commit(uint16_t *pChn);
+
+/// Forget the preloaded channel, e.g. when the chain is loaded by other means.
+void swmatrix_cancel_preload(void);
+
+/// Returns the preloaded channel or SWMATRIX_NO_PRELOAD.
+uint16_t swmatrix_get_preloaded(void);
+
+/** \brief Latch an arbitrary switch state with a single chain shift.
+ *
+ *  Any number of channels may be open at once. The multiplexer is not moved.
+ *  The current state can be read with swchain_get_image().
+ *
+ *  \param[in]  frame  swchain_get_chips() bytes, bit set means shorted.
+ */
+result_t swmatrix_apply_frame(const uint8_t *frame);
+
+/** \brief Open or short the channels of a list, leaving the others as they
+ *         are latched, with a single chain shift.
+ *
+ *  The latched state is read and changed under the matrix lock, so a
+ *  concurrent change isn't lost.
+ *
+ *  \param[in]  list  swchain_get_chips() bytes, the channels to change are
+ *                    open in it (bit cleared), e.g. from
+ *                    swmatrix_parse_channel_list().
+ */
+result_t swmatrix_change_channels(const uint8_t *list, bool open);
+
+bool swmatrix_frame_is_open(const uint8_t *frame, uint16_t chn);
+void swmatrix_frame_set_open(uint8_t *frame, uint16_t chn, bool open);
+
+/** \brief Parse a channel list like "1,5,100-107" into a frame.
+ *
+ *  \param[in,out] frame  The listed channels are opened (\p open) or
+ *                        shorted in it, the others are left untouched.
+ */
+result_t swmatrix_parse_channel_list(const char **pArgs, uint8_t *frame,
+                                     bool open);
+
+/** \brief Short all channels with the chain reset line.
+ *
+ *  Any transfer, trigger run or sequence in progress is stopped. The time
+ *  from \p requested to the reset pulse is stored for
+ *  swmatrix_get_short_time_ns().
+ *
+ *  \param[in]  requested  timebase_now() at the moment the short was
+ *                         requested, e.g. on the ISR entry.
+ *
+ *  \note May be called from a task or an MT_ISR.
+ */
+void swmatrix_short_all_fast(uint32_t requested);
+
+/** \brief Change the matrix geometry.
+ *
+ *  Stops the trigger run and sequence in progress and shorts all channels.
+ */
+result_t swmatrix_set_geometry(const swgeometry_t *pGeometry);
+
+/** \brief Write runs into the probe card map, or clear it if \p n is 0.
+ *
+ *  Stops the trigger run and sequence in progress and shorts all channels.
+ */
+result_t swmatrix_set_map(const swmap_run_t *runs, uint8_t n);
+
+/// Time to short measured during the last swmatrix_short_all_fast().
+uint32_t swmatrix_get_short_time_ns(void);
+
+/// Serialize access to the switch chain between tasks.
+void swmatrix_lock(void);
+void swmatrix_unlock(void);
+
+swmatrix_transition_t swmatrix_get_transition(void);
+void swmatrix_set_transition(swmatrix_transition_t transition);
+uint16_t swmatrix_get_dead_time(void);
+void swmatrix_set_dead_time(uint16_t us);
+
 swmatrix_cvres_t swmatrix_get_cvres(void);
 void swmatrix_set_cvres(swmatrix_cvres_t cvres);
 
+immutable_str swmatrix_meas_name(swmatrix_meas_t meas);
+immutable_str swmatrix_cvres_name(swmatrix_cvres_t cvres);
+result_t swmatrix_parse_meas(const char **pArgs, swmatrix_meas_t *pMeas);
+result_t swmatrix_parse_cvres(const char **pArgs, swmatrix_cvres_t *pCvres);
+
 #endif // !__SWMATRIX_H__
@@ -0,0 +1,201 @@
+/**
+ *  \file
+ *
+ *  \brief Switching matrix task
+ *
+ *  Requests are posted to the task queue as pointers to swmatrix_req_t
+ *  living on the stack of the waiting caller. The reply handle is a bit of
+ *  swmatrix_flags allocated for the time of the request, so any number of
+ *  tasks may wait for their replies without an event per task.
+ *
+ *  Asynchronous selections are kept in a single slot, so a burst of button
+ *  presses costs one chain shift for the last press instead of one for
+ *  each. The slot is queued only when it becomes occupied, which keeps it
+ *  in order with the other requests. The completion flag may be set for
+ *  a moment while a request is pending (a request posted between the check
+ *  and the flag post), so waiters check the slot again after waking up.
+ *
+ *  The emergency paths (swmatrix_short_all_fast(), the interlock and
+ *  trigger ISRs) don't go through the queue.
+ */
+
+#include "swmatrix_task.h"
+#include "debug.h"
+#include "mt.h"
+#include "swcounter.h"
+#include "swmatrix.h"
+
+// value of the request slot when it's empty
+#define SWMATRIX_NO_REQUEST 0xfffe
+
+// the counters are polled at least this often
+#define SWMATRIX_POLL_TICKS OS_TICKS_PER_SEC
+
+// flags usable as reply handles
+#define SWMATRIX_REPLY_FLAGS ((OS_FLAGS) ~SWMATRIX_FLAG_SELECTED)
+
+typedef struct {
+  swmatrix_req_op_t op;
+  uint16_t arg;
+  const void *pData;
+  OS_FLAGS reply;
+  result_t result;
+} swmatrix_req_t;
+
+OS_STK SwmatrixTask_stack[SWMATRIX_TASK_STACK_SIZE];
+OS_FLAG_GRP *swmatrix_flags;
+
+static void *queueStorage[SWMATRIX_QUEUE_SIZE];
+static OS_EVENT *queue;
+static OS_FLAGS repliesInUse;
+// posted to the queue instead of a request when the slot becomes occupied
+static uint8_t asyncMarker;
+static volatile bool asyncQueued;
+static volatile uint16_t request = SWMATRIX_NO_REQUEST;
+static volatile bool working;
+
+static void swmatrix_set_done_flag(void) {
+  INT8U err;
+  OSFlagPost(swmatrix_flags, SWMATRIX_FLAG_SELECTED, OS_FLAG_SET, &err);
+}
+
+static void swmatrix_handle_async(void) {
+  uint16_t chn;
+  MT_ATOMIC_EXPR((asyncQueued = false, chn = request,
+                  request = SWMATRIX_NO_REQUEST,
+                  working = chn != SWMATRIX_NO_REQUEST));
+  if (chn != SWMATRIX_NO_REQUEST)
+    swmatrix_select_channel(chn);
+  bool done;
+  MT_ATOMIC_EXPR((working = false, done = request == SWMATRIX_NO_REQUEST));
+  // a newer request has queued the slot again, go on with it
+  if (done)
+    swmatrix_set_done_flag();
+}
+
+static result_t swmatrix_execute(swmatrix_req_t *pReq) {
+  switch (pReq->op) {
+  case SWMATRIX_REQ_SELECT:
+    swmatrix_select_channel(pReq->arg);
+    return RESULT_OK;
+  case SWMATRIX_REQ_MEAS:
+    swmatrix_set_meas(pReq->arg);
+    return RESULT_OK;
+  case SWMATRIX_REQ_CVRES:
+    swmatrix_set_cvres(pReq->arg);
+    return RESULT_OK;
+  case SWMATRIX_REQ_PRELOAD:
+    return swmatrix_preload(pReq->arg);
+  case SWMATRIX_REQ_COMMIT:
+    return swmatrix_commit(&pReq->arg);
+  case SWMATRIX_REQ_FRAME:
+    return swmatrix_apply_frame(pReq->pData);
+  case SWMATRIX_REQ_OPEN:
+    return swmatrix_change_channels(pReq->pData, true);
+  case SWMATRIX_REQ_CLOSE:
+    return swmatrix_change_channels(pReq->pData, false);
+  }
+  return S("Unknown matrix request");
+}
+
+void SwmatrixTask(void *pArg) {
+  (void)pArg;
+  INT8U err;
+  swmatrix_flags = OSFlagCreate(SWMATRIX_FLAG_SELECTED, &err);
+  if (swmatrix_flags)
+    queue = OSQCreate(queueStorage, SWMATRIX_QUEUE_SIZE);
+  if (!queue) {
+    DPRINTF("Swmatrix: Can't create queue\n");
+    for (;;)
+      OSTimeDlyHMSM(1, 0, 0, 0);
+  }
+  for (;;) {
+    void *pMsg = OSQPend(queue, SWMATRIX_POLL_TICKS, &err);
+    if (err == OS_NO_ERR) {
+      if (pMsg == &asyncMarker) {
+        swmatrix_handle_async();
+      } else {
+        swmatrix_req_t *pReq = pMsg;
+        pReq->result = swmatrix_execute(pReq);
+        OSFlagPost(swmatrix_flags, pReq->reply, OS_FLAG_SET, &err);
+      }
+    }
+    // EEPROM writes are kept out of the switching paths
+    swcounter_poll();
+  }
+}
+
+static OS_FLAGS swmatrix_reply_alloc(void) {
+  OS_FLAGS reply;
+  // take the lowest free bit
+  MT_ATOMIC_EXPR((reply = SWMATRIX_REPLY_FLAGS & ~repliesInUse,
+                  reply &= -reply, repliesInUse |= reply));
+  return reply;
+}
+
+static void swmatrix_reply_free(OS_FLAGS reply) {
+  MT_ATOMIC_EXPR(repliesInUse &= ~reply);
+}
+
+bool swmatrix_call(swmatrix_req_op_t op, uint16_t *pArg, const void *pData,
+                   result_t *pRes) {
+  if (!queue || OSIntNesting || OSPrioCur == SWMATRIX_TASK_PRIO)
+    return false;
+  swmatrix_req_t req = {op, pArg ? *pArg : 0, pData, 0, RESULT_OK};
+  req.reply = swmatrix_reply_alloc();
+  if (!req.reply) {
+    *pRes = S("No matrix reply handle available");
+    return true;
+  }
+  INT8U err;
+  OSFlagPost(swmatrix_flags, req.reply, OS_FLAG_CLR, &err);
+  if (OSQPost(queue, &req) != OS_NO_ERR) {
+    swmatrix_reply_free(req.reply);
+    *pRes = S("Matrix queue full");
+    return true;
+  }
+  OSFlagPend(swmatrix_flags, req.reply, OS_FLAG_WAIT_SET_ALL, 0, &err);
+  swmatrix_reply_free(req.reply);
+  if (pArg)
+    *pArg = req.arg;
+  *pRes = req.result;
+  return true;
+}
+
+result_t swmatrix_select_channel_async(uint16_t chn) {
+  if (!queue) {
+    // the task is not running yet
+    swmatrix_select_channel(chn);
+    return RESULT_OK;
+  }
+  bool post;
+  MT_ATOMIC_EXPR((request = chn, post = !asyncQueued, asyncQueued = true));
+  INT8U err;
+  OSFlagPost(swmatrix_flags, SWMATRIX_FLAG_SELECTED, OS_FLAG_CLR, &err);
+  if (post && OSQPost(queue, &asyncMarker) != OS_NO_ERR) {
+    // the queue is full of requests, the selection is dropped
+    MT_ATOMIC_EXPR((asyncQueued = false, request = SWMATRIX_NO_REQUEST));
+    swmatrix_set_done_flag();
+    return S("Matrix queue full");
+  }
+  return RESULT_OK;
+}
+
+void swmatrix_cancel_async(void) { request = SWMATRIX_NO_REQUEST; }
+
+result_t swmatrix_wait_selected(INT16U timeout) {
+  if (!swmatrix_flags)
+    return RESULT_OK;
+  for (;;) {
+    INT8U err;
+    OSFlagPend(swmatrix_flags, SWMATRIX_FLAG_SELECTED, OS_FLAG_WAIT_SET_ALL,
+               timeout, &err);
+    if (err != OS_NO_ERR)
+      return S("Channel selection timeout");
+    bool done;
+    MT_ATOMIC_EXPR(done = request == SWMATRIX_NO_REQUEST && !working);
+    if (done)
+      return RESULT_OK;
+    OSTimeDly(1);
+  }
+}
@@ -0,0 +1,90 @@
+/**
+ *  \file
+ *
+ *  \brief Switching matrix task header file.
+ *
+ *  The matrix task owns the switch chain, multiplexer and measurement
+ *  setup. Other tasks calling swmatrix_select_channel(), swmatrix_preload()
+ *  and friends send a request through the task queue and wait for its
+ *  reply, so the requests from the CLI, buttons and sequencer are applied
+ *  one by one. Channel selections requested with
+ *  swmatrix_select_channel_async() don't wait for the reply at all.
+ */
+
+#ifndef _SWMATRIX_TASK_H__
+#define _SWMATRIX_TASK_H__
+
+#include "types.h"
+#include "ucos_ii.h"
+
+#ifndef SWMATRIX_TASK_STACK_SIZE
+#error "SWMATRIX_TASK_STACK_SIZE not defined"
+#endif
+
+#ifndef SWMATRIX_QUEUE_SIZE
+#error "SWMATRIX_QUEUE_SIZE not defined"
+#endif
+
+extern OS_STK SwmatrixTask_stack[SWMATRIX_TASK_STACK_SIZE];
+
+/// Flag set in swmatrix_flags when no asynchronous selection is pending.
+#define SWMATRIX_FLAG_SELECTED 0x0001
+
+/** \brief Completion flags of the matrix task, wait on them with OSFlagPend().
+ *
+ *  The other bits are reply handles of requests in progress.
+ */
+extern OS_FLAG_GRP *swmatrix_flags;
+
+typedef enum {
+  SWMATRIX_REQ_SELECT = 0, // arg: channel
+  SWMATRIX_REQ_MEAS,       // arg: swmatrix_meas_t
+  SWMATRIX_REQ_CVRES,      // arg: swmatrix_cvres_t
+  SWMATRIX_REQ_PRELOAD,    // arg: channel
+  SWMATRIX_REQ_COMMIT,     // arg: committed channel on return
+  SWMATRIX_REQ_FRAME,      // pData: frame
+  SWMATRIX_REQ_OPEN,       // pData: channels cleared in a frame
+  SWMATRIX_REQ_CLOSE       // pData: as SWMATRIX_REQ_OPEN
+} swmatrix_req_op_t;
+
+/**
+ * \brief Switching matrix task entry point.
+ */
+void SwmatrixTask(void *pArg) __attribute__((noreturn));
+
+/** \brief Execute a request in the matrix task and wait for the result.
+ *
+ *  \param[in,out] pArg   Request argument, some requests return a value in it.
+ *  \param[out]    pRes   Result of the request.
+ *
+ *  \return false if the caller has to execute the request by itself: it's
+ *          the matrix task, an ISR, or the task is not running yet.
+ */
+bool swmatrix_call(swmatrix_req_op_t op, uint16_t *pArg, const void *pData,
+                   result_t *pRes);
+
+/** \brief Request a channel selection and return immediately.
+ *
+ *  Only the latest request is applied, requests replaced before the task
+ *  got to them are dropped. SWMATRIX_FLAG_SELECTED is cleared until
+ *  the latest requested channel is selected.
+ *
+ *  \param[in]  chn  Channel or 0xffff for all shorted.
+ *
+ *  \return An error if the queue is full and the request was dropped.
+ */
+result_t swmatrix_select_channel_async(uint16_t chn);
+
+/** \brief Drop the pending selection request, if any.
+ *
+ *  \note May be called from an ISR.
+ */
+void swmatrix_cancel_async(void);
+
+/** \brief Wait until the latest requested channel is selected.
+ *
+ *  \param[in]  timeout  In OS ticks, 0 waits forever.
+ */
+result_t swmatrix_wait_selected(INT16U timeout);
+
+#endif // !_SWMATRIX_TASK_H__
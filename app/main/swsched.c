@@ -0,0 +1,293 @@
+/**
+ *  \file
+ *
+ *  \brief Scheduled channel and measurement changes
+ *
+ *  The queue is sorted by execution time. Only the 16 low bits of the
+ *  time fit the compare register, so the ISR fires once per timer period
+ *  until the high word matches too. The compare output isn't enabled, its
+ *  pin (PE0) drives the measurement relays.
+ *
+ *  A channel action whose preload didn't complete in time is dropped and
+ *  counted as missed. A channel added before the preloaded one replaces
+ *  its frame with the legacy transition, where the chain reset shorting
+ *  the latched channel is part of every switch, and is refused with the
+ *  single-shift one. The skew is taken after the switch, so it includes
+ *  the interrupt latency and the latch.
+ */
+
+#include "swsched.h"
+#include "TC_driver.h"
+#include "astring.h"
+#include "cli.h"
+#include "cmdarg.h"
+#include "interlock.h"
+#include "mt.h"
+#include "swchain.h"
+#include "swchnmap.h"
+#include "swmatrix.h"
+#include "timebase.h"
+#include "trigger.h"
+#include "trigout.h"
+#include <avr/interrupt.h>
+#include <string.h>
+
+#define SWSCHED_NONE 0xffff
+
+static swsched_action_t queue[SWSCHED_MAX_ACTIONS];
+static volatile uint8_t count;
+static volatile uint16_t preloaded = SWSCHED_NONE; // shifted into the chain
+static volatile bool ready;                        // preload complete
+static volatile bool displayStale;
+static volatile uint16_t displayChn = SWSCHED_NONE;
+static uint16_t fired;
+static uint16_t missed;
+static uint32_t skewLast; // timebase ticks
+static uint32_t skewMin;
+static uint32_t skewMax;
+
+static void swsched_preload(void);
+
+static void swsched_preload_done(void) {
+  // called from the DMA ISR, the frame is pending until the action fires,
+  // the next preload is started by swsched_run()
+  ready = true;
+}
+
+// Shift in the channel of the first channel action, with interrupts disabled
+static void swsched_preload(void) {
+  // the completion calls back
+  if (swchain_busy())
+    return;
+  uint8_t i;
+  for (i = 0; i < count && queue[i].type != SWSCHED_CHANNEL; i++)
+    ;
+  if (i == count)
+    return;
+  uint16_t chn = queue[i].arg;
+  if (chn == preloaded)
+    return;
+  // the frame of a missed action is dropped by resetting the chain, which
+  // shorts the latched channel as the legacy transition does anyway
+  if (swchain_pending()) {
+    if (preloaded == SWSCHED_NONE ||
+        swmatrix_get_transition() != SWMATRIX_TRANSITION_LEGACY)
+      return;
+    swchain_abort();
+  }
+  preloaded = chn;
+  ready = false;
+  swchain_prepare_single(swchnmap_chain_byte(chn), ~swchnmap_chain_mask(chn));
+  swchain_load_async(&swsched_preload_done);
+}
+
+static void swsched_fire(void) {
+  swsched_action_t action = queue[0];
+  memmove(&queue[0], &queue[1], --count * sizeof(queue[0]));
+  if (action.type == SWSCHED_MEAS) {
+    swmatrix_set_meas_fast(action.arg);
+  } else {
+    if (!ready || preloaded != action.arg) {
+      missed++;
+      return;
+    }
+    swchain_latch();
+    swmatrix_set_address(action.arg);
+    trigout_start(action.arg);
+    preloaded = SWSCHED_NONE;
+    ready = false;
+    displayChn = action.arg;
+  }
+  uint32_t skew = timebase_now() - action.due;
+  if (!fired || skew < skewMin)
+    skewMin = skew;
+  if (!fired || skew > skewMax)
+    skewMax = skew;
+  skewLast = skew;
+  fired++;
+  displayStale = true;
+}
+
+// Fire the due actions and arm the compare for the next one, with interrupts
+// disabled
+static void swsched_run(void) {
+  // retried on every compare, in case the chain was busy at the last try
+  swsched_preload();
+  while (count) {
+    // written directly, CCABUF would only be taken over on overflow
+    TCE0.CCA = (uint16_t)queue[0].due;
+    TC_ClearCCAFlag(&TCE0);
+    // the compare value may have been passed before it was written
+    if ((int32_t)(timebase_now() - queue[0].due) < 0) {
+      TC0_SetCCAIntLevel(&TCE0, TC_CCAINTLVL_HI_gc);
+      return;
+    }
+    swsched_fire();
+    swsched_preload();
+  }
+  TC0_SetCCAIntLevel(&TCE0, TC_CCAINTLVL_OFF_gc);
+}
+
+ISR(TCE0_CCA_vect) { swsched_run(); }
+
+result_t swsched_add(swsched_type_t type, uint16_t arg, uint32_t due) {
+  result_t ret = RESULT_OK;
+  if (interlock_is_tripped())
+    return S("Interlock tripped");
+  swmatrix_lock();
+  if (type == SWSCHED_CHANNEL && trigger_is_armed()) {
+    ret = S("Trigger is armed");
+  } else if (count >= SWSCHED_MAX_ACTIONS) {
+    ret = S("Schedule is full");
+  } else if (type == SWSCHED_CHANNEL && preloaded == SWSCHED_NONE &&
+             swchain_pending()) {
+    // not a frame of the schedule, the selected channel must stay
+    ret = S("Frame pending, commit or select a channel first");
+  } else {
+    uint8_t sreg = SREG;
+    cli();
+    // actions due at the same time are executed in the order queued
+    uint8_t i = count;
+    while (i && (int32_t)(queue[i - 1].due - due) > 0)
+      i--;
+    // ahead of the channel being preloaded
+    bool first = type == SWSCHED_CHANNEL && preloaded != SWSCHED_NONE;
+    for (uint8_t j = 0; first && j < i; j++)
+      if (queue[j].type == SWSCHED_CHANNEL)
+        first = false;
+    if (first && swmatrix_get_transition() != SWMATRIX_TRANSITION_LEGACY) {
+      ret = S("Earlier than the preloaded channel");
+    } else {
+      if (first) {
+        // reset shorts the latched channel, as a legacy transition would
+        swchain_abort();
+        preloaded = SWSCHED_NONE;
+        ready = false;
+      }
+      // the chain is owned by the schedule from now on
+      if (type == SWSCHED_CHANNEL)
+        swmatrix_cancel_preload();
+      memmove(&queue[i + 1], &queue[i], (count - i) * sizeof(queue[0]));
+      queue[i].due = due;
+      queue[i].arg = arg;
+      queue[i].type = type;
+      count++;
+      swsched_run();
+    }
+    SREG = sreg;
+  }
+  swmatrix_unlock();
+  return ret;
+}
+
+void swsched_abort(void) {
+  uint8_t sreg = SREG;
+  cli();
+  TC0_SetCCAIntLevel(&TCE0, TC_CCAINTLVL_OFF_gc);
+  count = 0;
+  preloaded = SWSCHED_NONE;
+  ready = false;
+  SREG = sreg;
+}
+
+void swsched_cancel(void) {
+  swsched_abort();
+  // let the preload finish, it stays pending until a channel is selected
+  while (swchain_busy())
+    OSTimeDly(1);
+}
+
+result_t swsched_parse_time(const char **pArgs, uint32_t *pDue,
+                            bool *pScheduled) {
+  const char *args = skipSpaces(*pArgs);
+  bool relative;
+  if (strnicmp_P(args, S("AT"), 2) == 0)
+    relative = false;
+  else if (strnicmp_P(args, S("IN"), 2) == 0)
+    relative = true;
+  else {
+    *pScheduled = false;
+    return RESULT_OK;
+  }
+  args += 2;
+  int32_t us;
+  result_t ret =
+      parseInt(&args, 0, relative ? SWSCHED_MAX_DELAY_US : INT32_MAX, &us);
+  if (ret != RESULT_OK)
+    return ret;
+  uint32_t now = timebase_now();
+  uint32_t due = timebase_us_to_ticks(us);
+  if (relative)
+    due += now;
+  else if ((int32_t)(due - now) < 0)
+    return S("Time has passed");
+  else if (due - now > timebase_us_to_ticks(SWSCHED_MAX_DELAY_US))
+    return S("Time out of range");
+  *pArgs = args;
+  *pDue = due;
+  *pScheduled = true;
+  return RESULT_OK;
+}
+
+bool swsched_poll_display(uint16_t *pChn) {
+  bool stale;
+  uint16_t chn;
+  MT_ATOMIC_EXPR((stale = displayStale, chn = displayChn,
+                  displayStale = false, displayChn = SWSCHED_NONE));
+  if (chn != SWSCHED_NONE)
+    *pChn = chn;
+  return stale;
+}
+
+//******************************************************************************
+// user interface
+//******************************************************************************
+
+static result_t swsched_list(void *pOut) {
+  swsched_action_t actions[SWSCHED_MAX_ACTIONS];
+  uint8_t n;
+  MT_ATOMIC_EXPR((n = count, memcpy(actions, queue, sizeof(actions))));
+  if (!n)
+    return CLI_TPRINTF("---");
+  for (uint8_t i = 0; i < n; i++) {
+    uint32_t due = timebase_ticks_to_us(actions[i].due);
+    if (actions[i].type == SWSCHED_CHANNEL)
+      CLI_TPRINTF_ASSERT("%lu CHANNEL %u\n", due, actions[i].arg);
+    else
+      CLI_TPRINTF_ASSERT("%lu MEASUREMENT %S\n", due,
+                         swmatrix_meas_name(actions[i].arg));
+  }
+  return RESULT_OK;
+}
+
+// Execution minus requested time of the executed actions, in ns
+static result_t swsched_skew(void *pOut) {
+  uint16_t f, m;
+  uint32_t last, min, max;
+  MT_ATOMIC_EXPR(
+      (f = fired, m = missed, last = skewLast, min = skewMin, max = skewMax));
+  if (!f)
+    return CLI_TPRINTF("FIRED 0 MISSED %u", m);
+  return CLI_TPRINTF("FIRED %u MISSED %u LAST %lu MIN %lu MAX %lu", f, m,
+                     timebase_ticks_to_ns(last), timebase_ticks_to_ns(min),
+                     timebase_ticks_to_ns(max));
+}
+
+DEFINE_COMMAND(ROOT_MATRIX, SCHEDULE, NULL, pObj, args, pOut) {
+  args = skipSpaces(args);
+  // get request
+  if (strlen(args) == 0 || strcmp_P(args, S("?")) == 0)
+    return swsched_list(pOut);
+  else if (stricmp_P(args, S("NOW")) == 0)
+    return CLI_TPRINTF("%lu", timebase_ticks_to_us(timebase_now()));
+  else if (stricmp_P(args, S("SKEW")) == 0)
+    return swsched_skew(pOut);
+  else if (stricmp_P(args, S("CLEAR")) == 0) {
+    swmatrix_lock();
+    swsched_cancel();
+    swmatrix_unlock();
+    MT_ATOMIC_EXPR((fired = 0, missed = 0));
+    return RESULT_OK;
+  }
+  return S("Expected NOW, SKEW, CLEAR or nothing");
+}
@@ -0,0 +1,77 @@
+/**
+ *  \file
+ *
+ *  \brief Scheduled channel and measurement changes header file.
+ *
+ *  Actions are queued with their execution time on the timebase. The
+ *  compare channel A of the timebase timer (TCE0) fires the earliest one
+ *  from its ISR. While waiting, the channel of the next channel action is
+ *  preloaded into the switch chain, so it's selected with a single latch
+ *  pulse, as by the trigger.
+ */
+
+#ifndef _SWSCHED_H__
+#define _SWSCHED_H__
+
+#include "app_cfg.h"
+#include "types.h"
+
+#ifndef SWSCHED_MAX_ACTIONS
+#error "SWSCHED_MAX_ACTIONS not defined"
+#endif
+
+/// Latest execution time accepted, relative to now.
+#define SWSCHED_MAX_DELAY_US 100000000UL
+
+typedef enum swsched_type_enum {
+  SWSCHED_CHANNEL = 0,
+  SWSCHED_MEAS = 1
+} swsched_type_t;
+
+typedef struct {
+  uint32_t due; // timebase ticks
+  uint16_t arg; // channel or swmatrix_meas_t
+  uint8_t type; // swsched_type_t
+} swsched_action_t;
+
+/** \brief Queue an action.
+ *
+ *  Channel actions can't be queued while the trigger is armed.
+ *
+ *  \param[in]  due  Execution time, timebase ticks.
+ */
+result_t swsched_add(swsched_type_t type, uint16_t arg, uint32_t due);
+
+/** \brief Drop all pending actions.
+ *
+ *  Has to be called with the switch chain locked (swmatrix_lock()).
+ */
+void swsched_cancel(void);
+
+/** \brief Drop all pending actions immediately.
+ *
+ *  \note May be called from an ISR.
+ */
+void swsched_abort(void);
+
+/** \brief Parse an optional execution time: AT <us> or IN <us>.
+ *
+ *  AT is an absolute time on the timebase (see MATRIX.SCHEDULE NOW), IN is
+ *  relative to now.
+ *
+ *  \param[out] pDue        Execution time, timebase ticks.
+ *  \param[out] pScheduled  False if the arguments hold no time.
+ */
+result_t swsched_parse_time(const char **pArgs, uint32_t *pDue,
+                            bool *pScheduled);
+
+/** \brief Check whether an action was executed since the last call.
+ *
+ *  Called by the UI task to catch up the display.
+ *
+ *  \param[in,out] pChn  Set to the last channel selected by the schedule,
+ *                       left untouched if only measurements changed.
+ */
+bool swsched_poll_display(uint16_t *pChn);
+
+#endif // !_SWSCHED_H__
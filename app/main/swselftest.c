@@ -0,0 +1,124 @@
+/**
+ *  \file
+ *
+ *  \brief Switching self benchmark
+ *
+ *  MATRIX.SELFTEST selects every channel of the configured geometry in
+ *  turn, then toggles the measurement type and steps through the CV
+ *  resistors, timing every change on the timebase. The changes go through
+ *  the matrix task like any other request, so the times include the task
+ *  round trip and the chain shifts, but not the settle times. The trigger
+ *  output stays quiet meanwhile, the instruments have nothing to measure.
+ *  The chain image (all the open channels), measurement type and CV
+ *  resistor are restored afterwards.
+ */
+
+#include "astring.h"
+#include "cli.h"
+#include "cmdarg.h"
+#include "interlock.h"
+#include "sequencer.h"
+#include "swchain.h"
+#include "swgeometry.h"
+#include "swmatrix.h"
+#include "timebase.h"
+#include "trigout.h"
+#include "ui.h"
+
+// measurement type changes timed, alternating IV and CV
+#define SWSELFTEST_MEAS_TOGGLES 8
+
+typedef struct {
+  uint16_t n;
+  uint32_t min; // timebase ticks
+  uint32_t max;
+  uint32_t sum;
+} swselftest_stat_t;
+
+static void swselftest_stat_add(swselftest_stat_t *pStat, uint32_t ticks) {
+  if (!pStat->n || ticks < pStat->min)
+    pStat->min = ticks;
+  if (!pStat->n || ticks > pStat->max)
+    pStat->max = ticks;
+  pStat->sum += ticks;
+  pStat->n++;
+}
+
+// Count, min, mean and max in ns
+static result_t swselftest_print(void *pOut, immutable_str name,
+                                 const swselftest_stat_t *pStat) {
+  if (!pStat->n)
+    return CLI_TPRINTF("%S 0\n", name);
+  return CLI_TPRINTF("%S %u MIN %lu MEAN %lu MAX %lu\n", name, pStat->n,
+                     timebase_ticks_to_ns(pStat->min),
+                     timebase_ticks_to_ns(pStat->sum / pStat->n),
+                     timebase_ticks_to_ns(pStat->max));
+}
+
+DEFINE_COMMAND(ROOT_MATRIX, SELFTEST, NULL, pObj, args, pOut) {
+  if (interlock_is_tripped())
+    return S("Interlock tripped");
+  uint16_t chn = ui_get_value();
+  swmatrix_meas_t meas = swmatrix_get_meas();
+  swmatrix_cvres_t cvres = swmatrix_get_cvres();
+  // the trigger and schedule are stopped by swmatrix_select_channel()
+  sequencer_abort();
+  uint8_t frame[SWCHAIN_MAX_CHIPS];
+  swmatrix_lock();
+  swchain_get_image(frame);
+  swmatrix_unlock();
+  trigout_suspend(true);
+
+  swselftest_stat_t chnStat = {0};
+  uint16_t channels = swgeometry_channels();
+  uint32_t start = timebase_now();
+  uint32_t t = start;
+  for (uint16_t i = 0; i < channels; i++) {
+    swmatrix_select_channel(i);
+    uint32_t now = timebase_now();
+    swselftest_stat_add(&chnStat, now - t);
+    t = now;
+  }
+  uint32_t total = timebase_ticks_to_us(t - start);
+
+  swselftest_stat_t measStat = {0};
+  for (uint8_t i = 0; i < SWSELFTEST_MEAS_TOGGLES; i++) {
+    t = timebase_now();
+    swmatrix_set_meas(i & 1 ? SWMATRIX_MEAS_CV : SWMATRIX_MEAS_IV);
+    swselftest_stat_add(&measStat, timebase_now() - t);
+  }
+
+  swselftest_stat_t cvresStat = {0};
+  for (uint8_t i = 0; i < 8; i++) {
+    t = timebase_now();
+    swmatrix_set_cvres(i);
+    swselftest_stat_add(&cvresStat, timebase_now() - t);
+  }
+
+  swmatrix_set_cvres(cvres);
+  swmatrix_set_meas(meas);
+  // several channels may have been open, the mux is moved back for the
+  // selected one
+  result_t ret = swmatrix_apply_frame(frame);
+  if (ret == RESULT_OK && chn != 0xffff)
+    swmatrix_set_address(chn);
+  trigout_suspend(false);
+  if (ret != RESULT_OK)
+    return ret;
+  // the interlock shorts everything, the sweep didn't complete
+  if (interlock_is_tripped())
+    return S("Interlock tripped");
+  ui_show_value(chn);
+
+  ret = swselftest_print(pOut, S("CHANNEL"), &chnStat);
+  if (ret != RESULT_OK)
+    return ret;
+  ret = swselftest_print(pOut, S("MEASUREMENT"), &measStat);
+  if (ret != RESULT_OK)
+    return ret;
+  ret = swselftest_print(pOut, S("CVRES"), &cvresStat);
+  if (ret != RESULT_OK)
+    return ret;
+  return CLI_TPRINTF("TOTAL %lu RATE %lu", total,
+                     total ? (uint32_t)channels * 1000000 / total : 0);
+}
@@ -0,0 +1,122 @@
+/**
+ *  \file
+ *
+ *  \brief Channel settle time table
+ *
+ *  The table has an entry for every possible row (up to one chip per row),
+ *  so changing the geometry keeps the times of the rows which still exist.
+ */
+
+#include "swsettle.h"
+#include "astring.h"
+#include "cli.h"
+#include "cmdarg.h"
+#include "config_file.h"
+#include "swgeometry.h"
+#include "swmap.h"
+#include "timebase.h"
+#include "ucos_ii.h"
+#include <string.h>
+
+// stored in EEPROM in front of the table, changes with its layout
+#define SWSETTLE_MAGIC 0x5E
+
+#define SWSETTLE_ROWS SWSETTLE_MAX_ROWS
+
+// microseconds per OS tick
+#define SWSETTLE_TICK_US (1000000UL / OS_TICKS_PER_SEC)
+
+typedef struct {
+  uint8_t magic;
+  uint16_t rows[SWSETTLE_ROWS]; // in SWSETTLE_UNIT_US
+} swsettle_file_t;
+
+static uint16_t rows[SWSETTLE_ROWS];
+
+void swsettle_init(void) {
+  swsettle_file_t file;
+  ConfigFile_Load(CONFIGFILE_SWSETTLE, &file, sizeof(file));
+  // erased EEPROM reads as 0xff
+  if (file.magic == SWSETTLE_MAGIC)
+    memcpy(rows, file.rows, sizeof(rows));
+  else
+    memset(rows, 0, sizeof(rows));
+}
+
+uint32_t swsettle_get_row(uint16_t row) {
+  // the rows beyond the table share the time of the last one
+  if (row >= SWSETTLE_ROWS)
+    row = SWSETTLE_ROWS - 1;
+  return (uint32_t)rows[row] * SWSETTLE_UNIT_US;
+}
+
+result_t swsettle_set_row(uint16_t row, uint32_t us) {
+  if (row >= SWSETTLE_ROWS)
+    return S("Row out of range");
+  if (us > SWSETTLE_MAX_US)
+    return S("Settle time out of range");
+  rows[row] = (us + SWSETTLE_UNIT_US - 1) / SWSETTLE_UNIT_US;
+  return RESULT_OK;
+}
+
+result_t swsettle_save(void) {
+  swsettle_file_t file;
+  file.magic = SWSETTLE_MAGIC;
+  memcpy(file.rows, rows, sizeof(rows));
+  return ConfigFile_Save(CONFIGFILE_SWSETTLE, &file, sizeof(file));
+}
+
+uint32_t swsettle_get_us(uint16_t chn) {
+  if (chn == 0xffff)
+    return 0;
+  return swsettle_get_row(swgeometry_row(swmap_physical(chn)));
+}
+
+uint16_t swsettle_get_ticks(uint16_t chn) {
+  return (swsettle_get_us(chn) + SWSETTLE_TICK_US - 1) / SWSETTLE_TICK_US;
+}
+
+void swsettle_wait(uint16_t chn, uint32_t since) {
+  uint32_t us = swsettle_get_us(chn);
+  if (!us)
+    return;
+  // a delay of n ticks lasts between n - 1 and n tick periods
+  uint16_t ticks = us / SWSETTLE_TICK_US;
+  if (ticks > 1)
+    OSTimeDly(ticks - 1);
+  uint32_t wait = timebase_us_to_ticks(us);
+  while (timebase_now() - since < wait)
+    ;
+}
+
+//******************************************************************************
+// user interface
+//******************************************************************************
+
+DEFINE_COMMAND(ROOT_MATRIX, SETTLE, NULL, pObj, args, pOut) {
+  args = skipSpaces(args);
+  // get request, one row per line
+  if (strlen(args) == 0 || strcmp_P(args, S("?")) == 0) {
+    for (uint16_t row = 0; row < swgeometry_rows(); row++)
+      CLI_TPRINTF_ASSERT("%u: %lu\n", row, swsettle_get_row(row));
+    return RESULT_OK;
+  }
+  // set request
+  int32_t first, last, us;
+  if (strnicmp_P(args, S("ALL"), 3) == 0) {
+    args += 3;
+    first = 0;
+    last = SWSETTLE_ROWS - 1;
+  } else {
+    result_t ret = parseInt(&args, 0, swgeometry_rows() - 1, &first);
+    if (ret != RESULT_OK)
+      return S("Expected row, ALL or nothing");
+    last = first;
+  }
+  result_t ret = parseInt(&args, 0, SWSETTLE_MAX_US, &us);
+  if (ret != RESULT_OK)
+    return ret;
+  for (int32_t row = first; row <= last; row++)
+    swsettle_set_row(row, us);
+  return swsettle_save();
+}
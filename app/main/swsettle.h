@@ -0,0 +1,55 @@
+/**
+ *  \file
+ *
+ *  \brief Channel settle time table header file.
+ *
+ *  Every row of the matrix has its own settle time, the time a channel
+ *  needs after it was switched before it can be measured. The table is
+ *  stored in EEPROM, all rows default to zero.
+ */
+
+#ifndef _SWSETTLE_H__
+#define _SWSETTLE_H__
+
+#include "app_cfg.h"
+#include "types.h"
+
+/// Resolution of the settle times.
+#define SWSETTLE_UNIT_US 10
+
+/// Longest settle time.
+#define SWSETTLE_MAX_US (0xffffUL * SWSETTLE_UNIT_US)
+
+/// Load the table from EEPROM.
+void swsettle_init(void);
+
+/// Settle time of a row in microseconds.
+uint32_t swsettle_get_row(uint16_t row);
+
+/** \brief Set the settle time of a row.
+ *
+ *  The time is rounded up to SWSETTLE_UNIT_US. The table is not saved.
+ */
+result_t swsettle_set_row(uint16_t row, uint32_t us);
+
+/// Store the table in EEPROM.
+result_t swsettle_save(void);
+
+/** \brief Settle time of a channel in microseconds.
+ *
+ *  The row is the one of the physical channel. Zero for all shorted (0xffff).
+ */
+uint32_t swsettle_get_us(uint16_t chn);
+
+/// Settle time of a channel rounded up to OS ticks.
+uint16_t swsettle_get_ticks(uint16_t chn);
+
+/** \brief Wait for the channel to settle.
+ *
+ *  Full ticks are slept, the remainder is busy waited on the timebase.
+ *
+ *  \param[in]  since  timebase_now() at the moment the channel was switched.
+ */
+void swsettle_wait(uint16_t chn, uint32_t since);
+
+#endif // !_SWSETTLE_H__
@@ -0,0 +1,190 @@
+/**
+ *  \file
+ *
+ *  \brief Telemetry push stream
+ *
+ *  The task samples the subscribed fields every TELEMETRY_POLL_MS and
+ *  compares them with the last record sent. The sensors are taken from the
+ *  cache of the environment monitor, never read here.
+ */
+
+#include "telemetry.h"
+#include "astring.h"
+#include "cli.h"
+#include "cmdarg.h"
+#include "crc16.h"
+#include "envmon.h"
+#include "mt.h"
+#include "swmatrix.h"
+#include "ui.h"
+#include <ctype.h>
+#include <string.h>
+
+OS_STK TelemetryTask_stack[TELEMETRY_TASK_STACK_SIZE];
+
+#define TELEMETRY_MS_TO_TICKS(_ms) ((_ms) / (1000 / OS_TICKS_PER_SEC))
+
+// channel, measurement, CV resistor and two sensors
+#define TELEMETRY_MAX_PAYLOAD (2 + 1 + 1 + 4 + 4)
+
+#define TELEMETRY_NUM_FIELDS 5
+
+static IMMUTABLE_STR(FIELD_CHANNEL) = "CHANNEL";
+static IMMUTABLE_STR(FIELD_MEASUREMENT) = "MEASUREMENT";
+static IMMUTABLE_STR(FIELD_CVRES) = "CVRES";
+static IMMUTABLE_STR(FIELD_MATRIX) = "MATRIX";
+static IMMUTABLE_STR(FIELD_PROBECARD) = "PROBECARD";
+
+// indexed by the bit of telemetry_field_t
+static const immutable_str fieldNames[TELEMETRY_NUM_FIELDS] IMMUTABLE_MEM = {
+    FIELD_CHANNEL, FIELD_MEASUREMENT, FIELD_CVRES, FIELD_MATRIX,
+    FIELD_PROBECARD};
+
+static uint8_t fields;
+static uint16_t interval; // ms
+static bool restart;      // a record is sent right after subscribing
+
+// written by DMA in the background, until the stream is flushed
+static uint8_t frame[4 + TELEMETRY_MAX_PAYLOAD + 2];
+
+static uint8_t telemetry_put16(uint8_t *p, uint16_t value) {
+  p[0] = (uint8_t)value;
+  p[1] = value >> 8;
+  return 2;
+}
+
+static int16_t telemetry_env(envmon_sensor_t sensor,
+                             envmon_quantity_t quantity) {
+  uint16_t raw;
+  if (!envmon_peek(sensor, quantity, &raw))
+    return TELEMETRY_ENV_INVALID;
+  return envmon_to_milli(quantity, raw) / 10;
+}
+
+static uint8_t telemetry_payload(uint8_t mask, uint8_t *p) {
+  uint8_t n = 0;
+  if (mask & TELEMETRY_CHANNEL)
+    n += telemetry_put16(p + n, ui_get_value());
+  if (mask & TELEMETRY_MEASUREMENT)
+    p[n++] = swmatrix_get_meas();
+  if (mask & TELEMETRY_CVRES)
+    p[n++] = swmatrix_get_cvres();
+  for (uint8_t sensor = 0; sensor < 2; sensor++) {
+    if (!(mask & (TELEMETRY_MATRIX << sensor)))
+      continue;
+    n += telemetry_put16(p + n, telemetry_env(sensor, ENVMON_TEMPERATURE));
+    n += telemetry_put16(p + n, telemetry_env(sensor, ENVMON_HUMIDITY));
+  }
+  return n;
+}
+
+static void telemetry_send(Stream *pStream, uint8_t seq, uint8_t mask,
+                           const uint8_t *payload, uint8_t len) {
+  // the previous frame may still be in transfer
+  Stream_Flush(pStream);
+  uint8_t n = 0;
+  frame[n++] = TELEMETRY_SOH;
+  frame[n++] = len;
+  frame[n++] = seq;
+  frame[n++] = mask;
+  memcpy(&frame[n], payload, len);
+  n += len;
+  uint16_t crc = CRC16_Init();
+  for (uint8_t i = 1; i < n; i++)
+    crc = CRC16_Update(crc, frame[i]);
+  n += telemetry_put16(&frame[n], crc);
+  Stream_Write(pStream, frame, n, NULL);
+}
+
+void TelemetryTask(void *pArg) {
+  Stream *pStream = (Stream *)pArg;
+  uint8_t last[TELEMETRY_MAX_PAYLOAD];
+  uint8_t lastLen = 0;
+  uint32_t lastTime = 0;
+  uint8_t seq = 0;
+  for (;;) {
+    OSTimeDly(TELEMETRY_MS_TO_TICKS(TELEMETRY_POLL_MS));
+    uint8_t mask;
+    uint16_t ms;
+    bool forced;
+    MT_ATOMIC_EXPR(
+        (mask = fields, ms = interval, forced = restart, restart = false));
+    if (!mask)
+      continue;
+    uint8_t payload[TELEMETRY_MAX_PAYLOAD];
+    uint8_t len = telemetry_payload(mask, payload);
+    uint32_t now = OSTimeGet();
+    bool due = ms && now - lastTime >= TELEMETRY_MS_TO_TICKS(ms);
+    if (!forced && !due && len == lastLen && memcmp(payload, last, len) == 0)
+      continue;
+    memcpy(last, payload, len);
+    lastLen = len;
+    lastTime = now;
+    telemetry_send(pStream, seq++, mask, payload, len);
+  }
+}
+
+result_t telemetry_subscribe(uint8_t _fields, uint16_t intervalMs) {
+  if (intervalMs > TELEMETRY_MAX_INTERVAL_MS)
+    return S("Interval out of range");
+  if (intervalMs && intervalMs < TELEMETRY_POLL_MS)
+    return S("Interval out of range");
+  MT_ATOMIC_EXPR((fields = _fields, interval = intervalMs, restart = true));
+  return RESULT_OK;
+}
+
+//******************************************************************************
+// user interface
+//******************************************************************************
+
+static result_t telemetry_parse_field(const char **pArgs, uint8_t *pMask) {
+  for (uint8_t i = 0; i < TELEMETRY_NUM_FIELDS; i++) {
+    immutable_str name = READ_IMMUTABLE_PTR(&fieldNames[i]);
+    size_t len = strlen_P(name);
+    if (strnicmp_P(*pArgs, name, len) == 0 &&
+        ((*pArgs)[len] == '\0' || isspace((unsigned char)(*pArgs)[len]))) {
+      *pMask |= 1 << i;
+      *pArgs += len;
+      return RESULT_OK;
+    }
+  }
+  return S("Expected CHANNEL, MEASUREMENT, CVRES, MATRIX, PROBECARD or OFF");
+}
+
+DEFINE_COMMAND(ROOT_SYS, SUBSCRIBE, NULL, pObj, args, pOut) {
+  args = skipSpaces(args);
+  // get request
+  if (strlen(args) == 0 || strcmp_P(args, S("?")) == 0) {
+    uint8_t mask;
+    uint16_t ms;
+    MT_ATOMIC_EXPR((mask = fields, ms = interval));
+    if (!mask)
+      return CLI_TPRINTF("OFF");
+    for (uint8_t i = 0; i < TELEMETRY_NUM_FIELDS; i++)
+      if (mask & (1 << i))
+        CLI_TPRINTF_ASSERT("%S ", READ_IMMUTABLE_PTR(&fieldNames[i]));
+    return CLI_TPRINTF("%u", ms);
+  }
+  // set request
+  if (stricmp_P(args, S("OFF")) == 0)
+    return telemetry_subscribe(0, 0);
+  uint8_t mask = 0;
+  int32_t ms = 0;
+  while (*args) {
+    if (isdigit((unsigned char)*args)) {
+      result_t ret = parseInt(&args, 0, TELEMETRY_MAX_INTERVAL_MS, &ms);
+      if (ret != RESULT_OK)
+        return ret;
+      if (*skipSpaces(args))
+        return S("Expected nothing after the interval");
+      break;
+    }
+    result_t ret = telemetry_parse_field(&args, &mask);
+    if (ret != RESULT_OK)
+      return ret;
+    args = skipSpaces(args);
+  }
+  if (!mask)
+    return S("Expected CHANNEL, MEASUREMENT, CVRES, MATRIX, PROBECARD or OFF");
+  return telemetry_subscribe(mask, ms);
+}
@@ -0,0 +1,65 @@
+/**
+ *  \file
+ *
+ *  \brief Telemetry push stream header file.
+ *
+ *  Once subscribed (SYS.SUBSCRIBE), the selected fields are pushed to the
+ *  console as binary records whenever one of them changes, and at least
+ *  every interval if one is set. A record is a frame:
+ *
+ *  SOH (0x01), length of the payload, sequence number, field mask, payload,
+ *  CRC16 (ModBus) of the bytes from the length to the end of the payload,
+ *  LSB first.
+ *
+ *  The payload holds the fields of the mask in the order of the bits, all
+ *  values are little endian. SOH is never part of the CLI output, a frame
+ *  is written in one piece, so it may only appear between two chunks of
+ *  the text.
+ */
+
+#ifndef _TELEMETRY_H__
+#define _TELEMETRY_H__
+
+#include "app_cfg.h"
+#include "stream.h"
+#include "types.h"
+#include "ucos_ii.h"
+
+#ifndef TELEMETRY_TASK_STACK_SIZE
+#error "TELEMETRY_TASK_STACK_SIZE not defined"
+#endif
+
+#ifndef TELEMETRY_POLL_MS
+#error "TELEMETRY_POLL_MS not defined"
+#endif
+
+#define TELEMETRY_SOH 0x01
+
+/// Temperature or humidity not read yet.
+#define TELEMETRY_ENV_INVALID ((int16_t)0x8000)
+
+typedef enum {
+  TELEMETRY_CHANNEL = 0x01,     // uint16_t, 0xffff if none
+  TELEMETRY_MEASUREMENT = 0x02, // uint8_t swmatrix_meas_t
+  TELEMETRY_CVRES = 0x04,       // uint8_t swmatrix_cvres_t
+  TELEMETRY_MATRIX = 0x08,      // int16_t deg C and % RH, in hundredths
+  TELEMETRY_PROBECARD = 0x10    // as TELEMETRY_MATRIX
+} telemetry_field_t;
+
+extern OS_STK TelemetryTask_stack[TELEMETRY_TASK_STACK_SIZE];
+
+/**
+ * \brief Telemetry task entry point.
+ *
+ * \param pArg  Stream the records are written to.
+ */
+void TelemetryTask(void *pArg) __attribute__((noreturn));
+
+/** \brief Select the pushed fields.
+ *
+ *  \param fields      telemetry_field_t bits, 0 stops the records.
+ *  \param intervalMs  Maximum time between records, 0 to push on change only.
+ */
+result_t telemetry_subscribe(uint8_t fields, uint16_t intervalMs);
+
+#endif // !_TELEMETRY_H__
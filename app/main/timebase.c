@@ -0,0 +1,50 @@
+/**
+ *  \file
+ *
+ *  \brief Free running microsecond timebase
+ */
+
+#include "timebase.h"
+#include "TC_driver.h"
+#include "clksys_getfreq.h"
+#include <avr/interrupt.h>
+
+static volatile uint16_t high;
+static uint16_t ticksPerMhz; // timer ticks per microsecond * 256
+
+ISR(TCE0_OVF_vect) { high++; }
+
+void timebase_init(void) {
+  // DIV8 prescaler, multiplied first as the clock may be below 8 MHz
+  ticksPerMhz = CLKSYS_GetFrequency(CLKSYS_OUTPUT_PER) * 32 / 1000000;
+  if (TCE0.CTRLA != TC_CLKSEL_OFF_gc)
+    return;
+  TC0_Reset(&TCE0);
+  TC_SetPeriod(&TCE0, 0xffff);
+  TC0_SetOverflowIntLevel(&TCE0, TC_OVFINTLVL_HI_gc);
+  TC0_ConfigClockSource(&TCE0, TC_CLKSEL_DIV8_gc);
+}
+
+uint32_t timebase_now(void) {
+  uint8_t sreg = SREG;
+  cli();
+  uint16_t lo = TCE0.CNT;
+  uint16_t hi = high;
+  // overflow not handled yet
+  if ((TCE0.INTFLAGS & TC0_OVFIF_bm) && lo < 0x8000)
+    hi++;
+  SREG = sreg;
+  return ((uint32_t)hi << 16) | lo;
+}
+
+uint32_t timebase_ticks_to_ns(uint32_t ticks) {
+  return (uint64_t)ticks * 256000 / ticksPerMhz;
+}
+
+uint32_t timebase_ticks_to_us(uint32_t ticks) {
+  return (uint64_t)ticks * 256 / ticksPerMhz;
+}
+
+uint32_t timebase_us_to_ticks(uint32_t us) {
+  return (uint64_t)us * ticksPerMhz / 256;
+}
@@ -0,0 +1,36 @@
+/**
+ *  \file
+ *
+ *  \brief Free running microsecond timebase header file.
+ *
+ *  TCE0 counts the peripheral clock divided by 8 (0.25 us at 32 MHz),
+ *  its overflows extend the counter to 32 bits.
+ */
+
+#ifndef _TIMEBASE_H__
+#define _TIMEBASE_H__
+
+#include "types.h"
+
+/** \brief Start the timebase.
+ *
+ *  \note May be called more than once, e.g. after the system clock change.
+ */
+void timebase_init(void);
+
+/** \brief Read the timebase.
+ *
+ *  \note May be called from an ISR.
+ */
+uint32_t timebase_now(void);
+
+/// Convert timebase ticks into nanoseconds.
+uint32_t timebase_ticks_to_ns(uint32_t ticks);
+
+/// Convert timebase ticks into microseconds.
+uint32_t timebase_ticks_to_us(uint32_t ticks);
+
+/// Convert microseconds into timebase ticks.
+uint32_t timebase_us_to_ticks(uint32_t us);
+
+#endif // !_TIMEBASE_H__
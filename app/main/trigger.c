@@ -0,0 +1,200 @@
+/**
+ *  \file
+ *
+ *  \brief Hardware triggered channel stepping
+ *
+ *  The trigger ISR only raises SYNC and writes the mux address, so
+ *  the trigger-to-switch latency is the interrupt latency plus a few
+ *  cycles. The next channel is shifted in by DMA while the current one
+ *  stays latched. A trigger coming before the preload completes is
+ *  ignored and counted as missed, as is a trigger overflowing the
+ *  capture buffer. A preload the chain refuses disarms the trigger and is
+ *  counted as missed too.
+ *
+ *  Channels change in the single-shift manner: the previous channel is
+ *  shorted by the same SYNC edge which opens the next one, with no dead
+ *  time before the mux moves.
+ */
+
+#include "trigger.h"
+#include "TC_driver.h"
+#include "astring.h"
+#include "cli.h"
+#include "cmdarg.h"
+#include "interlock.h"
+#include "mt.h"
+#include "swchain.h"
+#include "swchnmap.h"
+#include "swgeometry.h"
+#include "swmatrix.h"
+#include "swsched.h"
+#include "trigout.h"
+#include <avr/interrupt.h>
+
+static uint16_t channels[TRIGGER_MAX_CHANNELS];
+static uint8_t count;
+static volatile uint8_t pos;     // index of the preloaded channel
+static volatile uint8_t current; // index of the latched channel
+static volatile bool armed;
+static volatile bool ready; // preload complete
+static bool loop;
+static volatile uint16_t triggers;
+static volatile uint16_t missed;
+
+static void trigger_preload_done(void) { ready = true; }
+
+static result_t trigger_preload(void) {
+  uint16_t chn = channels[pos];
+  swchain_prepare_single(swchnmap_chain_byte(chn), ~swchnmap_chain_mask(chn));
+  return swchain_load_async(&trigger_preload_done);
+}
+
+void trigger_abort(void) {
+  TC0_SetCCAIntLevel(&TCD0, TC_CCAINTLVL_OFF_gc);
+  armed = false;
+}
+
+ISR(TCD0_CCA_vect) {
+  (void)TC_GetCaptureA(&TCD0);
+  // capture buffer overflow
+  if (TC_GetErrorFlag(&TCD0)) {
+    TC_ClearErrorFlag(&TCD0);
+    missed++;
+  }
+  if (!armed)
+    return;
+  triggers++;
+  if (!ready) {
+    missed++;
+    return;
+  }
+  ready = false;
+  swchain_latch();
+  swmatrix_set_address(channels[pos]);
+  trigout_start(channels[pos]);
+  current = pos;
+  if (++pos >= count) {
+    if (!loop) {
+      trigger_abort();
+      return;
+    }
+    pos = 0;
+  }
+  if (trigger_preload() != RESULT_OK) {
+    // no channel would ever be ready again
+    missed++;
+    trigger_abort();
+  }
+}
+
+void trigger_init(void) {
+  TRIGGER_IN_PORT.DIRCLR = TRIGGER_IN_bm;
+  TRIGGER_IN_PORT.TRIGGER_IN_PINCTRL = PORT_ISC_RISING_gc;
+  EVSYS.CH0MUX = TRIGGER_IN_EVSYS_CHMUX;
+  EVSYS.CH0CTRL = EVSYS_DIGFILT_2SAMPLES_gc;
+
+  TC0_ConfigClockSource(&TCD0, TC_CLKSEL_DIV1_gc);
+  TC0_ConfigInputCapture(&TCD0, TC_EVSEL_CH0_gc);
+  TC0_EnableCCChannels(&TCD0, TC0_CCAEN_bm);
+}
+
+result_t trigger_arm(bool _loop) {
+  if (!count)
+    return S("Trigger list is empty");
+  if (interlock_is_tripped())
+    return S("Interlock tripped");
+  swmatrix_lock();
+  if (armed)
+    trigger_disarm();
+  swsched_cancel();
+  // the selected channel must not be shorted to drop an earlier preload
+  if (swchain_pending()) {
+    swmatrix_unlock();
+    return S("Frame pending, commit or select a channel first");
+  }
+  swmatrix_cancel_preload();
+  pos = 0;
+  current = 0;
+  loop = _loop;
+  triggers = 0;
+  missed = 0;
+  ready = false;
+  result_t ret = trigger_preload();
+  if (ret != RESULT_OK) {
+    swmatrix_unlock();
+    return ret;
+  }
+
+  // drop triggers captured before arming
+  (void)TC_GetCaptureA(&TCD0);
+  (void)TC_GetCaptureA(&TCD0);
+  TC_ClearErrorFlag(&TCD0);
+  TC_ClearCCAFlag(&TCD0);
+  armed = true;
+  TC0_SetCCAIntLevel(&TCD0, TC_CCAINTLVL_HI_gc);
+  swmatrix_unlock();
+  return RESULT_OK;
+}
+
+void trigger_disarm(void) {
+  trigger_abort();
+  // let the preload finish, it stays pending until a channel is selected
+  while (swchain_busy())
+    OSTimeDly(1);
+}
+
+bool trigger_is_armed(void) { return armed; }
+
+//******************************************************************************
+// user interface
+//******************************************************************************
+
+DEFINE_COMMAND(ROOT_MATRIX_TRIGGER, ADD, NULL, pObj, args, pOut) {
+  if (armed)
+    return S("Trigger is armed");
+  args = skipSpaces(args);
+  while (*args) {
+    if (count >= TRIGGER_MAX_CHANNELS)
+      return S("Trigger list is full");
+    int32_t chn;
+    result_t ret = parseInt(&args, 0, swgeometry_channels() - 1, &chn);
+    if (ret != RESULT_OK)
+      return ret;
+    channels[count++] = chn;
+    args = skipSpaces(args);
+  }
+  return RESULT_OK;
+}
+
+DEFINE_COMMAND(ROOT_MATRIX_TRIGGER, CLEAR, NULL, pObj, args, pOut) {
+  if (armed)
+    return S("Trigger is armed");
+  count = 0;
+  return RESULT_OK;
+}
+
+DEFINE_COMMAND(ROOT_MATRIX_TRIGGER, ARM, NULL, pObj, args, pOut) {
+  args = skipSpaces(args);
+  bool _loop = false;
+  if (stricmp_P(args, S("LOOP")) == 0)
+    _loop = true;
+  else if (*args)
+    return S("Expected LOOP or nothing");
+  return trigger_arm(_loop);
+}
+
+DEFINE_COMMAND(ROOT_MATRIX_TRIGGER, DISARM, NULL, pObj, args, pOut) {
+  swmatrix_lock();
+  trigger_disarm();
+  swmatrix_unlock();
+  return RESULT_OK;
+}
+
+DEFINE_COMMAND(ROOT_MATRIX_TRIGGER, STATUS, NULL, pObj, args, pOut) {
+  uint16_t t, m;
+  MT_ATOMIC_EXPR((t = triggers, m = missed));
+  return CLI_TPRINTF("%S %u/%u TRIGGERS %u MISSED %u",
+                     armed ? S("ARMED") : S("IDLE"), current, count, t, m);
+}
+
+DEFINE_COMMAND_ARRAY(ROOT_MATRIX, TRIGGER, STATUS);
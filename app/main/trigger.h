@@ -0,0 +1,45 @@
+/**
+ *  \file
+ *
+ *  \brief Hardware triggered channel stepping header file.
+ *
+ *  Every rising edge on the trigger input latches the channel preloaded
+ *  into the switch chain and starts preloading the next channel from
+ *  the list. The edge is routed through the event system to an input
+ *  capture of TCD0, so no task is involved.
+ */
+
+#ifndef _TRIGGER_H__
+#define _TRIGGER_H__
+
+#include "app_cfg.h"
+#include "types.h"
+
+#ifndef TRIGGER_MAX_CHANNELS
+#error "TRIGGER_MAX_CHANNELS not defined"
+#endif
+
+/// Setup the trigger input pin, event channel and timer.
+void trigger_init(void);
+
+/** \brief Start stepping through the channel list on triggers.
+ *
+ *  \param[in]  loop  Start over from the first channel after the last one.
+ */
+result_t trigger_arm(bool loop);
+
+/** \brief Stop reacting on triggers.
+ *
+ *  Has to be called with the switch chain locked (swmatrix_lock()).
+ */
+void trigger_disarm(void);
+
+/** \brief Stop reacting on triggers immediately.
+ *
+ *  \note May be called from an ISR.
+ */
+void trigger_abort(void);
+
+bool trigger_is_armed(void);
+
+#endif // !_TRIGGER_H__
@@ -0,0 +1,154 @@
+/**
+ *  \file
+ *
+ *  \brief Trigger output
+ *
+ *  As for the schedule, only the 16 low bits of the due time fit the
+ *  compare register, the ISR keeps firing once per timer period until the
+ *  high word matches too. The compare output isn't enabled, the pin is
+ *  driven by the ISR.
+ */
+
+#include "trigout.h"
+#include "TC_driver.h"
+#include "astring.h"
+#include "cli.h"
+#include "cmdarg.h"
+#include "swsettle.h"
+#include "timebase.h"
+#include <avr/interrupt.h>
+#include <string.h>
+
+typedef enum {
+  TRIGOUT_IDLE = 0,
+  TRIGOUT_SETTLING = 1,
+  TRIGOUT_PULSE = 2
+} trigout_state_t;
+
+static volatile uint8_t state;
+static uint32_t due; // timebase ticks
+static bool enabled;
+static volatile bool suspended;
+static bool activeLow;
+static uint16_t width = TRIGOUT_DEFAULT_WIDTH_US;
+static uint32_t widthTicks;
+
+static void trigout_assert(bool active) {
+  if (active != activeLow)
+    TRIGGER_OUT_PORT.OUTSET = TRIGGER_OUT_bm;
+  else
+    TRIGGER_OUT_PORT.OUTCLR = TRIGGER_OUT_bm;
+}
+
+// Advance the state machine and arm the compare, with interrupts disabled
+static void trigout_run(void) {
+  while (state != TRIGOUT_IDLE) {
+    // written directly, CCBBUF would only be taken over on overflow
+    TCE0.CCB = (uint16_t)due;
+    TC_ClearCCBFlag(&TCE0);
+    // the compare value may have been passed before it was written
+    if ((int32_t)(timebase_now() - due) < 0) {
+      TC0_SetCCBIntLevel(&TCE0, TC_CCBINTLVL_HI_gc);
+      return;
+    }
+    if (state == TRIGOUT_SETTLING) {
+      trigout_assert(true);
+      state = TRIGOUT_PULSE;
+      // held until the next channel change
+      if (!width)
+        break;
+      due = timebase_now() + widthTicks;
+    } else {
+      trigout_assert(false);
+      state = TRIGOUT_IDLE;
+    }
+  }
+  TC0_SetCCBIntLevel(&TCE0, TC_CCBINTLVL_OFF_gc);
+}
+
+ISR(TCE0_CCB_vect) { trigout_run(); }
+
+void trigout_init(void) {
+  // the timebase frequency may have changed since the last call
+  widthTicks = timebase_us_to_ticks(width);
+  trigout_abort();
+  TRIGGER_OUT_PORT.DIRSET = TRIGGER_OUT_bm;
+}
+
+void trigout_start(uint16_t chn) {
+  uint32_t now = timebase_now();
+  uint8_t sreg = SREG;
+  cli();
+  trigout_abort();
+  if (enabled && !suspended && chn != 0xffff) {
+    due = now + timebase_us_to_ticks(swsettle_get_us(chn));
+    state = TRIGOUT_SETTLING;
+    trigout_run();
+  }
+  SREG = sreg;
+}
+
+void trigout_suspend(bool on) {
+  suspended = on;
+  trigout_abort();
+}
+
+void trigout_abort(void) {
+  uint8_t sreg = SREG;
+  cli();
+  TC0_SetCCBIntLevel(&TCE0, TC_CCBINTLVL_OFF_gc);
+  state = TRIGOUT_IDLE;
+  trigout_assert(false);
+  SREG = sreg;
+}
+
+result_t trigout_set(bool _enabled, bool _activeLow, uint16_t widthUs) {
+  if (widthUs > TRIGOUT_MAX_WIDTH_US)
+    return S("Pulse width out of range");
+  uint32_t ticks = timebase_us_to_ticks(widthUs);
+  uint8_t sreg = SREG;
+  cli();
+  trigout_abort();
+  enabled = _enabled;
+  activeLow = _activeLow;
+  width = widthUs;
+  widthTicks = ticks;
+  // drive the new inactive level
+  trigout_assert(false);
+  SREG = sreg;
+  return RESULT_OK;
+}
+
+//******************************************************************************
+// user interface
+//******************************************************************************
+
+DEFINE_COMMAND(ROOT_MATRIX, TRIGOUT, NULL, pObj, args, pOut) {
+  args = skipSpaces(args);
+  // get request
+  if (strlen(args) == 0 || strcmp_P(args, S("?")) == 0) {
+    if (!enabled)
+      return CLI_TPRINTF("OFF");
+    return CLI_TPRINTF("%S %u", activeLow ? S("LOW") : S("HIGH"), width);
+  }
+  // set request
+  if (stricmp_P(args, S("OFF")) == 0)
+    return trigout_set(false, activeLow, width);
+  bool low;
+  if (strnicmp_P(args, S("HIGH"), 4) == 0) {
+    args += 4;
+    low = false;
+  } else if (strnicmp_P(args, S("LOW"), 3) == 0) {
+    args += 3;
+    low = true;
+  } else {
+    return S("Expected HIGH, LOW, OFF or nothing");
+  }
+  int32_t us = width;
+  if (*skipSpaces(args)) {
+    result_t ret = parseInt(&args, 0, TRIGOUT_MAX_WIDTH_US, &us);
+    if (ret != RESULT_OK)
+      return ret;
+  }
+  return trigout_set(true, low, us);
+}
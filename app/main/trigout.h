@@ -0,0 +1,53 @@
+/**
+ *  \file
+ *
+ *  \brief Trigger output header file.
+ *
+ *  Every channel selection pulses the trigger output once the settle time
+ *  of the channel (swsettle.h) has elapsed since the chain was latched and
+ *  the multiplexer moved. The delay and the pulse are timed by the compare
+ *  channel B of the timebase timer (TCE0), not by OS ticks.
+ */
+
+#ifndef _TRIGOUT_H__
+#define _TRIGOUT_H__
+
+#include "app_cfg.h"
+#include "types.h"
+
+#define TRIGOUT_DEFAULT_WIDTH_US 10
+#define TRIGOUT_MAX_WIDTH_US 10000
+
+/// Setup the pin, driven to the inactive level.
+void trigout_init(void);
+
+/** \brief Start the settle delay of a newly selected channel.
+ *
+ *  A pulse pending or in progress is ended first. Nothing is pulsed for
+ *  0xffff (all shorted) or while the output is disabled.
+ *
+ *  \note May be called from an ISR.
+ */
+void trigout_start(uint16_t chn);
+
+/** \brief Suppress the pulses, e.g. while the channels are benchmarked.
+ *
+ *  A pulse pending or in progress is ended.
+ */
+void trigout_suspend(bool on);
+
+/** \brief End the pending or current pulse.
+ *
+ *  \note May be called from an ISR.
+ */
+void trigout_abort(void);
+
+/** \brief Configure the output.
+ *
+ *  \param[in]  activeLow  The pulse drives the pin low instead of high.
+ *  \param[in]  widthUs    Pulse width, 0 keeps the output asserted until the
+ *                         next channel change.
+ */
+result_t trigout_set(bool enabled, bool activeLow, uint16_t widthUs);
+
+#endif // !_TRIGOUT_H__
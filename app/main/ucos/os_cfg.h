@@ -49,7 +49,7 @@
      /* ... MUST NEVER be higher than 254!                           */
 
 #define OS_MAX_EVENTS                                                          \
-  10 /* Max. number of event control blocks in your application      */
+  12 /* Max. number of event control blocks in your application      */
 #define OS_MAX_FLAGS                                                           \
   5 /* Max. number of Event Flag Groups    in your application      */
 #define OS_MAX_MEM_PART                                                        \
@@ -151,7 +151,7 @@
 
 /* ---------------------- MESSAGE QUEUES ---------------------- */
 #define OS_Q_EN                                                                \
-  0 /* Enable (1) or Disable (0) code generation for QUEUES         */
+  1 /* Enable (1) or Disable (0) code generation for QUEUES         */
 #define OS_Q_ACCEPT_EN                                                         \
   0 /*     Include code for OSQAccept()                             */
 #define OS_Q_DEL_EN                                                            \
@@ -161,7 +161,7 @@
 #define OS_Q_PEND_ABORT_EN                                                     \
   0 /*     Include code for OSQPendAbort()                          */
 #define OS_Q_POST_EN                                                           \
-  0 /*     Include code for OSQPost()                               */
+  1 /*     Include code for OSQPost()                               */
 #define OS_Q_POST_FRONT_EN                                                     \
   0 /*     Include code for OSQPostFront()                          */
 #define OS_Q_POST_OPT_EN                                                       \
@@ -195,7 +195,7 @@
 
 /* --------------------- TIMER MANAGEMENT --------------------- */
 #define OS_TMR_EN                                                              \
-  1 /* Enable (1) or Disable (0) code generation for TIMERS         */
+  0 /* Enable (1) or Disable (0) code generation for TIMERS         */
 #define OS_TMR_CFG_MAX                                                         \
   2 /*     Maximum number of timers                                 */
 #define OS_TMR_CFG_NAME_SIZE                                                   \
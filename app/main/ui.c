@@ -12,9 +12,16 @@
 #include "cmdarg.h"
 #include "config_file.h"
 #include "debug.h"
+#include "interlock.h"
 #include "led.h"
 #include "mt.h"
+#include "pins.h"
+#include "swgeometry.h"
+#include "swmap.h"
 #include "swmatrix.h"
+#include "swmatrix_task.h"
+#include "swsched.h"
+#include "timebase.h"
 
 OS_STK UITask_stack[UI_TASK_STACK_SIZE];
 static ui_cnf_t ui;
@@ -27,21 +34,21 @@ inline void keyboard_init() {
   PORTJ.PIN2CTRL = PORT_OPC_TOTEM_gc;
 }
 inline uint8_t keyboard_get() { return PORTJ.IN & 0xf; }
-inline void led_display_oe_high() { PORTF.OUTSET = 0x10; }
+inline void led_display_oe_high() { PINS_SET(DISPLAY, 0x10); }
 
-inline void led_display_oe_low() { PORTF.OUTCLR = 0x10; }
+inline void led_display_oe_low() { PINS_CLR(DISPLAY, 0x10); }
 
-inline void led_display_srclk_high() { PORTF.OUTSET = 0x80; }
+inline void led_display_srclk_high() { PINS_SET(DISPLAY, 0x80); }
 
-inline void led_display_srclk_low() { PORTF.OUTCLR = 0x80; }
+inline void led_display_srclk_low() { PINS_CLR(DISPLAY, 0x80); }
 
-inline void led_display_data_high() { PORTF.OUTSET = 0x20; }
+inline void led_display_data_high() { PINS_SET(DISPLAY, 0x20); }
 
-inline void led_display_data_low() { PORTF.OUTCLR = 0x20; }
+inline void led_display_data_low() { PINS_CLR(DISPLAY, 0x20); }
 
-inline void led_display_rclk_high() { PORTH.OUTSET = 0x80; }
+inline void led_display_rclk_high() { PINS_SET(STATUS, 0x80); }
 
-inline void led_display_rclk_low() { PORTH.OUTCLR = 0x80; }
+inline void led_display_rclk_low() { PINS_CLR(STATUS, 0x80); }
 
 inline void led_display_init() {
   led_display_oe_high();
@@ -117,6 +124,8 @@ uint8_t SEGMAP[] = {
 void led_display_update(void) {
   uint16_t val = ui.value;
   ui_representation_t representation = ui.representation;
+  if (ui.physical && val != 0xffff)
+    val = swmap_physical(val);
   uint8_t d0, d1, d2;
   if (val == 0xffff) {
     d0 = d1 = d2 = SEGF;
@@ -124,6 +133,10 @@ void led_display_update(void) {
     led_display_send8bits(~SEGG);
     led_display_send8bits(~SEGG);
   } else {
+    // three digits, larger channel numbers are shown in hex
+    if ((representation == UI_REPRESENTATION_DEC && val > 999) ||
+        (representation == UI_REPRESENTATION_OCT && val > 0777))
+      representation = UI_REPRESENTATION_HEX;
     if (representation == UI_REPRESENTATION_DEC) {
       d0 = val % 10;
       val /= 10;
@@ -170,15 +183,40 @@ void ui_set_representation(ui_representation_t representation) {
 }
 
 void ui_set_value(uint16_t val) {
+  if (interlock_is_tripped())
+    val = 0xffff;
   ui.value = val;
   led_display_update();
   swmatrix_select_channel(val);
 }
 
+result_t ui_request_value(uint16_t val) {
+  if (interlock_is_tripped())
+    val = 0xffff;
+  result_t ret = swmatrix_select_channel_async(val);
+  if (ret != RESULT_OK)
+    return ret;
+  ui.value = val;
+  led_display_update();
+  return RESULT_OK;
+}
+
+void ui_show_value(uint16_t val) {
+  ui.value = val;
+  led_display_update();
+}
+
 uint16_t ui_get_value() { return ui.value; }
 
 ui_representation_t ui_get_representation() { return ui.representation; }
 
+void ui_set_physical(bool physical) {
+  ui.physical = physical;
+  led_display_update();
+}
+
+bool ui_get_physical(void) { return ui.physical; }
+
 uint8_t ui_get_timeout() { return ui.timeout; }
 
 void UiTask(void *pArg) {
@@ -200,23 +238,34 @@ void UiTask(void *pArg) {
     //       LED_On(LED_HV);
     //       OSTimeDlyHMSM(0, 0, 0, 10);
     //       LED_Off(LED_HV);
+    // the interlock shorts the channels from its ISR, catch up the display
+    if (interlock_is_tripped() && ui_get_value() != 0xffff)
+      ui_show_value(0xffff);
+    // scheduled changes are executed from an ISR, catch up the display too
+    newValue = ui_get_value();
+    if (swsched_poll_display(&newValue))
+      ui_show_value(newValue);
     keyboard = keyboard_get();
+    // both buttons short all channels at once, without debouncing
+    if (keyboard == 0x03 && ui_get_value() != 0xffff) {
+      swmatrix_short_all_fast(timebase_now());
+      ui_show_value(0xffff);
+    }
     if (keyboard) {
       if (pressed > 10) {
         switch (keyboard) {
         case 0x01:
+          // wrap around the channels of the configured geometry
           newValue = ui_get_value() + 1;
-          newValue &= 0xfff;
-          ui_set_value(newValue);
+          if (newValue >= swgeometry_channels())
+            newValue = 0;
+          ui_request_value(newValue);
           break;
         case 0x02:
-          newValue = ui_get_value() - 1;
-          newValue &= 0xfff;
-          ui_set_value(newValue);
-          break;
-        case 0x03:
-          newValue = 0xffff;
-          ui_set_value(newValue);
+          newValue = ui_get_value();
+          if (newValue == 0 || newValue >= swgeometry_channels())
+            newValue = swgeometry_channels();
+          ui_request_value(newValue - 1);
           break;
         case 0x08:
           swmatrix_toggle_meas();
@@ -256,6 +305,8 @@ static IMMUTABLE_STR(DISPLAY_AUTO) = "AUTO";
 static IMMUTABLE_STR(REPR_DEC) = "DEC";
 static IMMUTABLE_STR(REPR_OCT) = "OCT";
 static IMMUTABLE_STR(REPR_HEX) = "HEX";
+static IMMUTABLE_STR(REPR_LOGICAL) = "LOGICAL";
+static IMMUTABLE_STR(REPR_PHYSICAL) = "PHYSICAL";
 
 DEFINE_COMMAND(ROOT_UI, DISPLAY, NULL, pObj, args, pOut) {
   args = skipSpaces(args);
@@ -320,6 +371,9 @@ DEFINE_COMMAND(ROOT_UI, REPRESENTATION, NULL, pObj, args, pOut) {
       CLI_TPRINTFI_ASSERT(REPR_HEX);
     else
       CLI_TPRINTFI_ASSERT(REPR_OCT);
+    // logical numbers are the default, keep the answer short then
+    if (ui_get_physical())
+      CLI_TPRINTF_ASSERT(" %S", REPR_PHYSICAL);
     return RESULT_OK;
   }
   // set request
@@ -332,8 +386,14 @@ DEFINE_COMMAND(ROOT_UI, REPRESENTATION, NULL, pObj, args, pOut) {
   } else if (stricmp_P(args, REPR_OCT) == 0) {
     ui_set_representation(UI_REPRESENTATION_OCT);
     return RESULT_OK;
+  } else if (stricmp_P(args, REPR_LOGICAL) == 0) {
+    ui_set_physical(false);
+    return RESULT_OK;
+  } else if (stricmp_P(args, REPR_PHYSICAL) == 0) {
+    ui_set_physical(true);
+    return RESULT_OK;
   } else
-    return S("Expected DEC/HEX/OCT");
+    return S("Expected DEC/HEX/OCT/LOGICAL/PHYSICAL");
   return RESULT_OK;
 }
 
@@ -37,6 +37,7 @@ typedef struct {
   uint8_t autoDisplayState;
   uint16_t value;
   ui_representation_t representation;
+  bool physical; // display the physical channel instead of the logical one
 } ui_cnf_t;
 
 /**
@@ -44,6 +45,18 @@ typedef struct {
  */
 void UiTask(void *pArg) __attribute__((noreturn));
 
+void ui_set_value(uint16_t val);
+/// Display a channel and select it by the matrix task, without waiting. A
+/// request dropped for a full queue fails and isn't displayed.
+result_t ui_request_value(uint16_t val);
+/// Display a channel already selected by other means.
+void ui_show_value(uint16_t val);
+uint16_t ui_get_value(void);
+void led_display_update(void);
+
+void ui_set_physical(bool physical);
+bool ui_get_physical(void);
+
 void ui_set_display(ui_display_t displ);
 ui_display_t ui_get_display();
 void ui_set_timeout(uint8_t timeout);
@@ -15,6 +15,7 @@
 #include "debug.h"
 #include "led.h"
 #include "mt.h"
+#include "pins.h"
 #include "sp_driver.h"
 #include "swmatrix.h"
 #include "system_driver.h"
@@ -112,15 +113,17 @@ void Board_Init(void) {
 
   System_WakeUp();
 
+  PINS_Init();
   LED_Init();
   LED_Off(LED_ALL);
   analog_supply_enable();
   analog_supply_leds_enable();
   //    LED_On(LED_STA);
+  // the matrix geometry is stored in EEPROM
+  ConfigFile_Init();
   swmatrix_init();
   setBoardId();
 
-  ConfigFile_Init();
   //    SCMonitor_Init();
 
   //  initAnalog();
@@ -18,6 +18,25 @@
  */
 #define CLKSYS_XOSC_FREQUENCY 24000000
 
+// external trigger input (rising edge), routed to event channel 0
+
+#define TRIGGER_IN_PORT PORTK
+#define TRIGGER_IN_PINCTRL PIN0CTRL
+#define TRIGGER_IN_bm 0x01
+#define TRIGGER_IN_EVSYS_CHMUX EVSYS_CHMUX_PORTK_PIN0_gc
+
+// trigger output, pulsed once the selected channel has settled
+
+#define TRIGGER_OUT_PORT PORTK
+#define TRIGGER_OUT_bm 0x02
+
+// interlock input (pulled up, asserted high), pin change interrupt 0
+
+#define INTERLOCK_IN_PORT PORTJ
+#define INTERLOCK_IN_PINCTRL PIN4CTRL
+#define INTERLOCK_IN_bm 0x10
+#define INTERLOCK_IN_vect PORTJ_INT0_vect
+
 // device addresses
 
 #define TB2DC_DAQ_TIME_ADDR 0x6020
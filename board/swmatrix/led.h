@@ -9,6 +9,8 @@
 #ifndef _LED_H__
 #define _LED_H__
 
+#include "pins.h"
+
 #define LED_HV 0x40
 #define LED_STATUS 0x20
 #define LED_CV 0x10
@@ -21,7 +23,7 @@
  */
 #define LED_Init()                                                             \
   do {                                                                         \
-    PORTH.DIRSET = LED_ALL;                                                    \
+    PINS_OUTPUT(STATUS, LED_ALL);                                              \
   } while (0)
 
 /** \brief Switch on LED(s).
@@ -30,7 +32,7 @@
  */
 #define LED_On(_mask)                                                          \
   do {                                                                         \
-    PORTH.OUTSET = (uint8_t)(_mask);                                           \
+    PINS_SET(STATUS, _mask);                                                   \
   } while (0)
 
 /** \brief Switch off LED(s).
@@ -39,7 +41,7 @@
  */
 #define LED_Off(_mask)                                                         \
   do {                                                                         \
-    PORTH.OUTCLR = (uint8_t)(_mask);                                           \
+    PINS_CLR(STATUS, _mask);                                                   \
   } while (0)
 
 /** \brief Toggle LED(s).
@@ -188,6 +188,11 @@ SECTIONS
      _end = . ;
      PROVIDE (__heap_start = .) ;
   }  > data
+  /* RAM kept free above the static data for the stack of main() and the
+     interrupts before the OS runs, override with --defsym */
+  __stack_reserve = DEFINED(__stack_reserve) ? __stack_reserve : 0x200 ;
+  ASSERT (__heap_start + __stack_reserve <= ORIGIN(data) + LENGTH(data),
+          "static RAM leaves less than __stack_reserve bytes to the stack")
   .eeprom  :
   {
     *(.eeprom*)
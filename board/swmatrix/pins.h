@@ -0,0 +1,73 @@
+/**
+ *  \file
+ *
+ *  \brief Bit-banged pin access through the XMEGA virtual ports.
+ *
+ *  The ports driven bit by bit are mapped onto VPORT0-3, which live in
+ *  the I/O space. Setting or clearing a single constant pin then compiles
+ *  to one SBI/CBI instead of an STS to OUTSET/OUTCLR, and reading a pin to
+ *  IN instead of LDS. Masks of more than one pin or not known at compile
+ *  time still go through OUTSET/OUTCLR, which keeps them atomic with
+ *  respect to other tasks and ISRs writing the same port.
+ *
+ *  Pins are named by group: PINS_SET(CHAIN, 0x10) sets PD4.
+ */
+
+#ifndef _PINS_H__
+#define _PINS_H__
+
+#define PINS_CHAIN_PORT PORTD // switch chain, A8
+#define PINS_CHAIN_VPORT VPORT0
+#define PINS_DISPLAY_PORT PORTF // 7-segment shift register clock and data
+#define PINS_DISPLAY_VPORT VPORT1
+#define PINS_STATUS_PORT PORTH // LEDs, display latch, CVM
+#define PINS_STATUS_VPORT VPORT2
+#define PINS_I2C_PORT PORTK // bit-banged I2C of both sensors
+#define PINS_I2C_VPORT VPORT3
+
+/// Map the virtual ports, has to be called before any other PINS_ macro.
+#define PINS_Init()                                                            \
+  do {                                                                         \
+    PORTCFG.VPCTRLA = PORTCFG_VP0MAP_PORTD_gc | PORTCFG_VP1MAP_PORTF_gc;       \
+    PORTCFG.VPCTRLB = PORTCFG_VP2MAP_PORTH_gc | PORTCFG_VP3MAP_PORTK_gc;       \
+  } while (0)
+
+// true if _bm is a compile time constant with exactly one bit set
+#define PINS_SINGLE_BIT(_bm)                                                   \
+  (__builtin_constant_p(_bm) && (_bm) && !((_bm) & ((_bm)-1)))
+
+#define PINS_SET(_grp, _bm)                                                    \
+  do {                                                                         \
+    if (PINS_SINGLE_BIT(_bm))                                                  \
+      PINS_##_grp##_VPORT.OUT |= (uint8_t)(_bm);                               \
+    else                                                                       \
+      PINS_##_grp##_PORT.OUTSET = (uint8_t)(_bm);                              \
+  } while (0)
+
+#define PINS_CLR(_grp, _bm)                                                    \
+  do {                                                                         \
+    if (PINS_SINGLE_BIT(_bm))                                                  \
+      PINS_##_grp##_VPORT.OUT &= (uint8_t) ~(_bm);                             \
+    else                                                                       \
+      PINS_##_grp##_PORT.OUTCLR = (uint8_t)(_bm);                              \
+  } while (0)
+
+#define PINS_OUTPUT(_grp, _bm)                                                 \
+  do {                                                                         \
+    if (PINS_SINGLE_BIT(_bm))                                                  \
+      PINS_##_grp##_VPORT.DIR |= (uint8_t)(_bm);                               \
+    else                                                                       \
+      PINS_##_grp##_PORT.DIRSET = (uint8_t)(_bm);                              \
+  } while (0)
+
+#define PINS_INPUT(_grp, _bm)                                                  \
+  do {                                                                         \
+    if (PINS_SINGLE_BIT(_bm))                                                  \
+      PINS_##_grp##_VPORT.DIR &= (uint8_t) ~(_bm);                             \
+    else                                                                       \
+      PINS_##_grp##_PORT.DIRCLR = (uint8_t)(_bm);                              \
+  } while (0)
+
+#define PINS_READ(_grp, _bm) (PINS_##_grp##_VPORT.IN & (uint8_t)(_bm))
+
+#endif // !_PINS_H__
@@ -28,4 +28,11 @@ void Serial_Flush(uint8_t port);
 
 char Serial_Getc(uint8_t port);
 
+/** \brief Number of times received data was lost.
+ *
+ *  Counted when the input FIFO couldn't take all the received bytes, or
+ *  (SERIAL_USE_RX_DMA) the DMA fell behind.
+ */
+uint16_t Serial_GetRxOverruns(uint8_t port);
+
 #endif // !_SERIAL_H__
@@ -1,212 +1,397 @@
-#include "avr_compiler.h"
-#include "TWI_master.h"
-#include <util/delay.h>
-
-
-
-
-
-//#define READ_SDA() (PORTK.IN & 0x80)
-//#define READ_SCL() (PORTK.IN & 0x40)
-
-/*! \brief Delay used to generate clock */
-#define DELAY 2
-
-/*! \brief Delay used for STOP condition */
-#define SCL_SDA_DELAY 1
-
-char twi_send_slave_address(twi_iface_t *iface, unsigned char slave_address, unsigned char read);
-
-void twi_write_scl(twi_iface_t *iface, char x);
-void twi_write_sda(twi_iface_t *iface, char x);
-char twi_write_byte(twi_iface_t *iface,unsigned char byte);
-char twi_read_byte(twi_iface_t *iface, unsigned char* rcvdata, unsigned char ack);
-
-
-void delay_cycles(unsigned char i)
-{
-  volatile unsigned j;
-  for(j=0;j<i;j++);
-}
-/*! \brief initialize twi master mode
- */ 
-void twi_init(twi_iface_t *iface)
-{
-//  PORTK.DIRSET = 0xc0;
-  twi_write_sda(iface,1);
-  twi_write_scl(iface,1);
-} 
-
-
-/*! \brief Sends start condition
- */
-char twi_start_cond(twi_iface_t *iface)
-{
-  delay_cycles(DELAY);
-  twi_write_sda(iface,0);
-  delay_cycles(DELAY);
-  twi_write_scl(iface,0);  
-  delay_cycles(DELAY);
-  return 0;
-}
-
-char twi_stop_cond(twi_iface_t *iface)
-{
-  delay_cycles(DELAY);
-  twi_write_scl(iface,1);
-  delay_cycles(DELAY);
-  twi_write_sda(iface,1);
-  delay_cycles(DELAY);
-  return 0;
-}
-
-char twi_send_slave_address(twi_iface_t *iface, unsigned char slave_address, unsigned char read)
-{
-  return twi_write_byte(iface,slave_address<<1 | read );
-} 
-
-char twi_write_data(twi_iface_t *iface, unsigned char slave_address, unsigned char* indata, char bytes)
-{
-  unsigned char index, ack = 0;
-  
-  if(twi_start_cond(iface))
-    return 1;
-  if(twi_send_slave_address(iface, slave_address, WRITE))
-    return 2;  
-  
-  for(index = 0; index < bytes; index++)
-  {
-     ack = twi_write_byte(iface,indata[index]);
-     if(ack)
-      break;    
-  }
-  //put stop here
-  twi_stop_cond(iface);
-  if (ack) return 3;
-  return 0;
-  
-}
-
-char twi_write_byte(twi_iface_t *iface, unsigned char byte)
-{
-  char bit;
-  for (bit = 0; bit < 8; bit++) 
-  {
-     twi_write_sda(iface,(byte & 0x80) != 0);
-     delay_cycles(DELAY);
-     twi_write_scl(iface,1);//goes high
-     delay_cycles(DELAY);
-     twi_write_scl(iface,0);//goes low
-     byte <<= 1;
-     delay_cycles(DELAY);
-  }
-  //release SDA
-  twi_write_sda(iface,1);
-  delay_cycles(DELAY);
- 
-  twi_write_scl(iface,1);//goes high
-  //Check for acknowledgment
-  char sda=(PORTK.IN & iface->sda);
-  delay_cycles(DELAY);
-  twi_write_scl(iface,0);//goes low
-  return sda;
-}  
-char twi_read_data(twi_iface_t *iface, unsigned char slave_address,unsigned char* data, char bytes)
-{
-  unsigned char index,err,ack = 0;
-  if(twi_start_cond(iface))
-    return 1;
-  if(twi_send_slave_address(iface,slave_address,READ))
-    return 2;  
-  for(index = 0; index < bytes; index++)
-  {
-    ack=0;
-    if (index==bytes-1)ack=1;
-
-    err = twi_read_byte(iface,&data[index], ack);
-    if(err)
-      break; 
-  }
-  //put stop here
-  twi_stop_cond(iface);
-  return err;
-  
-  
-}  
-
-/*! \brief Reads one byte into buffer.
-    \param rcvdata Pointer to data buffer
-    \param bytes  Number of bytes to read
-    \param index Position of the incoming byte in hte receive buffer 
-    \return 1 if successful, otherwise 0
- */
-char twi_read_byte(twi_iface_t *iface, unsigned char* rcvdata, unsigned char ack)
-{
-  unsigned char byte = 0;
-  unsigned char bit = 0;
-  //release SDA
-  twi_write_sda(iface,1);
-  for (bit = 0; bit < 8; bit++) 
-  {
-    twi_write_scl(iface,1);//goes high
-    if(PORTK.IN&iface->sda)
-      byte|= (1 << (7- bit));
-    delay_cycles(DELAY);
-    twi_write_scl(iface,0);//goes low
-    delay_cycles(DELAY);
-  }
-  *rcvdata = byte;
-
-  twi_write_sda(iface,ack);
-  twi_write_scl(iface,1); //goes high for the 9th clock
-  delay_cycles(DELAY);
-  //Pull SCL low
-  twi_write_scl(iface,0); //end of byte with acknowledgment. 
-  //release SDA
-  twi_write_sda(iface,1);
-  delay_cycles(DELAY);
-  return 0;
-}  
-/*! \brief Writes SCL.
-    \param x tristates SCL when x = 1, other wise 0
- */
-void twi_write_scl (twi_iface_t *iface, char x)
-{
-      if(x)
-      {
-            PORTK.OUTSET = iface->scl; //pullup
-            PORTK.DIRCLR = iface->scl; //tristate it
-            //check clock stretching
-            while(!(PORTK.IN & iface->scl));
-//            PORTK.DIRSET = 0x40; //output 
-//            PORTK.OUTSET = 0x40; //set it low
-
-      }
-      else
-      {
-            PORTK.DIRSET = iface->scl; //output 
-            PORTK.OUTCLR = iface->scl; //set it low
-      }
-}
-
-/*! \brief Writes SDA.
-    \param x tristates SDA when x = 1, other wise 0
- */
-void twi_write_sda (twi_iface_t *iface, char x)
-{
-      if(x)
-      {
-            PORTK.DIRCLR = iface->sda; //tristate it
-            PORTK.OUTSET = iface->sda; //pull up
-
-//            PORTK.DIRSET = 0x80; //tristate it
-//            PORTK.OUTSET = 0x80; //pull up
-      }
-      else
-      {
-            PORTK.DIRSET = iface->sda; //output 
-            PORTK.OUTCLR = iface->sda; //set it low
-            
-      }
-}
-
+/**
+ *  \file
+ *
+ *  \brief Bit-banged I2C master
+ *
+ *  Every tick of TCE1 advances the state machine by one step: a byte takes
+ *  nine bits of three steps each (set SDA, release SCL, sample and pull SCL
+ *  low). A slave stretching the clock holds the third step. The lines are
+ *  never driven high, a released line is pulled up by the bus.
+ *
+ *  A transaction running longer than its timeout is ended with the
+ *  recovery sequence: up to nine clocks until the slave releases SDA,
+ *  followed by STOP. The same sequence runs before a transaction which
+ *  finds SDA held low.
+ *
+ *  The overflow ISR doesn't call into the OS. Once the queue is empty it
+ *  hands over to the compare A ISR, which posts the completion semaphore.
+ *  Both run at the high level, as a high level MT_ISR must not nest in a
+ *  plain one. Before the OS runs, twi_wait() steps the engine itself.
+ */
+
+#include "TWI_master.h"
+#include "TC_driver.h"
+#include "astring.h"
+#include "avr_compiler.h"
+#include "clksys_getfreq.h"
+#include "mt.h"
+#include "pins.h"
+
+// backstop for a stopped engine, all transactions have their own timeouts
+#define TWI_WAIT_TIMEOUT_TICKS (2 * OS_TICKS_PER_SEC)
+
+// clocks sent to free SDA held low by a slave
+#define TWI_RECOVER_CLOCKS 9
+
+typedef enum {
+  TWI_OP_START = 0,
+  TWI_OP_BYTE = 1,
+  TWI_OP_STOP = 2,
+  TWI_OP_RECOVER = 3
+} twi_op_t;
+
+typedef enum {
+  TWI_BYTE_ADDR = 0,
+  TWI_BYTE_WRITE = 1,
+  TWI_BYTE_READ = 2
+} twi_byte_t;
+
+static twi_trans_t *volatile head;
+static twi_trans_t *tail;
+static uint8_t sda; // pins of the current bus
+static uint8_t scl;
+static uint8_t op;    // twi_op_t
+static uint8_t phase; // step within the operation
+static uint8_t kind;  // twi_byte_t of the current byte
+static uint16_t out;  // 8 data bits and the acknowledge, MSB first
+static uint16_t in;
+static uint8_t bits; // left of the byte, or recovery clocks left
+static uint8_t pos;  // byte within the write or read part
+static bool reading; // read part of the transaction
+static bool started; // START of the transaction sent
+static uint32_t ticksLeft;
+static MT_SemType lock;
+static MT_SemType doneSem;
+
+static void twi_release(uint8_t bm) {
+  PINS_INPUT(I2C, bm);
+  PINS_SET(I2C, bm);
+}
+
+static void twi_pull(uint8_t bm) {
+  PINS_CLR(I2C, bm);
+  PINS_OUTPUT(I2C, bm);
+}
+
+static uint32_t twi_timeout_ticks(const twi_trans_t *t) {
+  uint16_t ms = t->timeoutMs ? t->timeoutMs : TWI_DEFAULT_TIMEOUT_MS;
+  return (uint32_t)ms * (TWI_TICK_HZ / 1000);
+}
+
+static void twi_set_op(uint8_t _op) {
+  op = _op;
+  phase = 0;
+}
+
+static void twi_load_byte(uint8_t _kind, uint8_t byte, bool nack) {
+  kind = _kind;
+  out = (uint16_t)byte << 1 | nack;
+  in = 0;
+  bits = 9;
+  twi_set_op(TWI_OP_BYTE);
+}
+
+static void twi_recover(void) {
+  bits = TWI_RECOVER_CLOCKS;
+  twi_set_op(TWI_OP_RECOVER);
+}
+
+static void twi_begin(twi_trans_t *t) {
+  sda = t->iface->sda;
+  scl = t->iface->scl;
+  ticksLeft = twi_timeout_ticks(t);
+  pos = 0;
+  reading = !t->wrLen;
+  started = false;
+  twi_release(sda);
+  twi_release(scl);
+  if (PINS_READ(I2C, sda)) {
+    started = true;
+    twi_set_op(TWI_OP_START);
+  } else {
+    twi_recover();
+  }
+}
+
+// The rest of the queue completes in the compare ISR
+static void twi_idle(void) {
+  TC1_SetOverflowIntLevel(&TCE1, TC_OVFINTLVL_OFF_gc);
+  TCE1.CCA = 0;
+  TC_ClearCCAFlag(&TCE1);
+  TC1_SetCCAIntLevel(&TCE1, TC_CCAINTLVL_HI_gc);
+}
+
+static void twi_finish(void) {
+  twi_trans_t *t = head;
+  if (t->status == TWI_PENDING)
+    t->status = TWI_OK;
+  head = t->next;
+  if (head)
+    twi_begin(head);
+  else
+    twi_idle();
+}
+
+static void twi_fail(uint8_t status) {
+  if (head->status == TWI_PENDING)
+    head->status = status;
+}
+
+// Next byte of the transaction, once the previous one was clocked out
+static void twi_next_byte(void) {
+  twi_trans_t *t = head;
+  if (kind == TWI_BYTE_READ) {
+    t->rdData[pos++] = in >> 1;
+  } else {
+    // not acknowledged
+    if (in & 1) {
+      twi_fail(TWI_NACK);
+      twi_set_op(TWI_OP_STOP);
+      return;
+    }
+    if (kind == TWI_BYTE_WRITE)
+      pos++;
+  }
+  if (!reading) {
+    if (pos < t->wrLen) {
+      twi_load_byte(TWI_BYTE_WRITE, t->wrData[pos], true);
+    } else if (t->rdLen) {
+      // repeated START
+      reading = true;
+      pos = 0;
+      twi_set_op(TWI_OP_START);
+    } else {
+      twi_set_op(TWI_OP_STOP);
+    }
+  } else if (pos < t->rdLen) {
+    // the last byte is not acknowledged
+    twi_load_byte(TWI_BYTE_READ, 0xff, pos == t->rdLen - 1);
+  } else {
+    twi_set_op(TWI_OP_STOP);
+  }
+}
+
+static void twi_step(void) {
+  if (!--ticksLeft) {
+    if (head->status == TWI_PENDING) {
+      twi_fail(TWI_TIMEOUT);
+      ticksLeft = twi_timeout_ticks(head);
+      twi_recover();
+    } else {
+      // the bus doesn't recover, give up
+      twi_release(sda);
+      twi_release(scl);
+      twi_finish();
+    }
+    return;
+  }
+  switch (op) {
+  case TWI_OP_START:
+    // SCL is low after a byte, or high on an idle bus
+    if (phase == 0) {
+      twi_release(sda);
+    } else if (phase == 1) {
+      twi_release(scl);
+    } else if (phase == 2) {
+      // clock stretching
+      if (!PINS_READ(I2C, scl))
+        return;
+      twi_pull(sda);
+    } else {
+      twi_pull(scl);
+      twi_load_byte(TWI_BYTE_ADDR, head->addr << 1 | reading, true);
+      return;
+    }
+    phase++;
+    return;
+
+  case TWI_OP_BYTE:
+    if (phase == 0) {
+      if (out & 0x100)
+        twi_release(sda);
+      else
+        twi_pull(sda);
+      phase = 1;
+    } else if (phase == 1) {
+      twi_release(scl);
+      phase = 2;
+    } else {
+      if (!PINS_READ(I2C, scl))
+        return;
+      in = in << 1 | !!PINS_READ(I2C, sda);
+      twi_pull(scl);
+      out <<= 1;
+      phase = 0;
+      if (!--bits)
+        twi_next_byte();
+    }
+    return;
+
+  case TWI_OP_STOP:
+    // SCL is low
+    if (phase == 0) {
+      twi_pull(sda);
+    } else if (phase == 1) {
+      twi_release(scl);
+    } else if (phase == 2) {
+      if (!PINS_READ(I2C, scl))
+        return;
+      twi_release(sda);
+    } else {
+      // the bus was recovered before the transaction started
+      if (!started && head->status == TWI_PENDING) {
+        started = true;
+        twi_set_op(TWI_OP_START);
+      } else {
+        twi_finish();
+      }
+      return;
+    }
+    phase++;
+    return;
+
+  case TWI_OP_RECOVER:
+    if (phase == 0) {
+      twi_release(sda);
+      twi_pull(scl);
+      phase = 1;
+    } else if (phase == 1) {
+      twi_release(scl);
+      phase = 2;
+    } else {
+      if (!PINS_READ(I2C, scl))
+        return;
+      if (PINS_READ(I2C, sda)) {
+        twi_pull(scl);
+        twi_set_op(TWI_OP_STOP);
+      } else if (!--bits) {
+        twi_fail(TWI_BUS_ERROR);
+        twi_pull(scl);
+        twi_set_op(TWI_OP_STOP);
+      } else {
+        phase = 0;
+      }
+    }
+    return;
+  }
+}
+
+ISR(TCE1_OVF_vect) { twi_step(); }
+
+MT_ISR(TCE1_CCA_vect) {
+  TC1_SetCCAIntLevel(&TCE1, TC_CCAINTLVL_OFF_gc);
+  TC1_ConfigClockSource(&TCE1, TC_CLKSEL_OFF_gc);
+  if (doneSem)
+    MT_SEM_POST(doneSem);
+}
+
+// One step of the engine if the timer overflowed, whether or not the
+// interrupts are enabled yet
+static void twi_poll(void) {
+  uint8_t sreg = SREG;
+  cli();
+  if (head && (TCE1.INTFLAGS & TC1_OVFIF_bm)) {
+    TC_ClearOverflowFlag(&TCE1);
+    twi_step();
+  }
+  SREG = sreg;
+}
+
+result_t twi_init(void) {
+  if (TCE1.CTRLA == TC_CLKSEL_OFF_gc) {
+    TC1_Reset(&TCE1);
+    TC1_ConfigWGM(&TCE1, TC_WGMODE_NORMAL_gc);
+  }
+  // the system clock may have changed since the last call
+  TC_SetPeriod(&TCE1,
+               CLKSYS_GetFrequency(CLKSYS_OUTPUT_PER) / TWI_TICK_HZ - 1);
+  // semaphores can't be created before the OS is initialized
+  if (OSRunning && !lock && !MT_SEM_INIT(lock, 1))
+    return S("twi_init: Can't create semaphore");
+  if (OSRunning && !doneSem && !MT_SEM_INIT(doneSem, 0))
+    return S("twi_init: Can't create semaphore");
+  return RESULT_OK;
+}
+
+void twi_lock(void) {
+  if (lock)
+    MT_SEM_PEND(lock, 0);
+}
+
+void twi_unlock(void) {
+  if (lock)
+    MT_SEM_POST(lock);
+}
+
+void twi_submit(twi_trans_t *list) {
+  twi_trans_t *last = list;
+  for (twi_trans_t *t = list; t; t = t->next) {
+    t->status = TWI_PENDING;
+    last = t;
+  }
+  uint8_t sreg = SREG;
+  cli();
+  // the previous queue drained, but its completion wasn't signalled yet
+  bool completing = TCE1.INTCTRLB & TC1_CCAINTLVL_gm;
+  if (head) {
+    // chained to the transactions in progress
+    tail->next = list;
+    tail = last;
+  } else {
+    head = list;
+    tail = last;
+    twi_begin(head);
+    TC1_SetCCAIntLevel(&TCE1, TC_CCAINTLVL_OFF_gc);
+    TC_SetCount(&TCE1, 0);
+    TC_ClearOverflowFlag(&TCE1);
+    TC1_SetOverflowIntLevel(&TCE1, TC_OVFINTLVL_HI_gc);
+    TC1_ConfigClockSource(&TCE1, TC_CLKSEL_DIV1_gc);
+  }
+  SREG = sreg;
+  if (completing && doneSem)
+    MT_SEM_POST(doneSem);
+}
+
+twi_status_t twi_wait(twi_trans_t *list) {
+  twi_status_t status = TWI_OK;
+  for (twi_trans_t *t = list; t; t = t->next) {
+    while (t->status == TWI_PENDING) {
+      // no OS to wait with yet, the timeouts of the transaction bound the
+      // polling
+      if (!OSRunning || !doneSem) {
+        twi_poll();
+        continue;
+      }
+      if (!MT_SEM_PEND(doneSem, TWI_WAIT_TIMEOUT_TICKS))
+        twi_abort();
+    }
+    if (status == TWI_OK && t->status != TWI_OK)
+      status = t->status;
+  }
+  return status;
+}
+
+twi_status_t twi_transfer(twi_trans_t *list) {
+  twi_lock();
+  twi_submit(list);
+  twi_status_t status = twi_wait(list);
+  twi_unlock();
+  return status;
+}
+
+void twi_abort(void) {
+  uint8_t sreg = SREG;
+  cli();
+  TC1_ConfigClockSource(&TCE1, TC_CLKSEL_OFF_gc);
+  TC1_SetOverflowIntLevel(&TCE1, TC_OVFINTLVL_OFF_gc);
+  TC1_SetCCAIntLevel(&TCE1, TC_CCAINTLVL_OFF_gc);
+  for (twi_trans_t *t = head; t; t = t->next)
+    if (t->status == TWI_PENDING)
+      t->status = TWI_TIMEOUT;
+  if (head) {
+    twi_release(sda);
+    twi_release(scl);
+  }
+  head = NULL;
+  SREG = sreg;
+}
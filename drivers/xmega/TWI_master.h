@@ -1,7 +1,25 @@
+/**
+ *  \file
+ *
+ *  \brief Bit-banged I2C master header file.
+ *
+ *  The buses are driven by a state machine paced by the TCE1 overflow
+ *  interrupt, three interrupts per SCL period. Transactions are queued and
+ *  executed in the background, the caller sleeps on a semaphore until they
+ *  complete. Both buses (twi_iface_t) share the engine, a caller has to
+ *  hold twi_lock() while its transactions are queued.
+ */
+
 #ifndef TWI_MASTER_H_
 #define TWI_MASTER_H_
 
+#include "types.h"
+
+/*! \brief Rate of the pacing interrupt, SCL runs at a third of it */
+#define TWI_TICK_HZ 100000UL
 
+/*! \brief Timeout of a transaction with timeoutMs left at 0 */
+#define TWI_DEFAULT_TIMEOUT_MS 50
 
 #define WRITE 0x0
 #define READ 0x1
@@ -13,13 +31,55 @@ typedef struct twi_iface_struct
 }
 twi_iface_t;
 
-void twi_init(twi_iface_t *iface);
+typedef enum twi_status_enum {
+  TWI_PENDING = 0,
+  TWI_OK = 1,
+  TWI_NACK = 2,     // address or data byte not acknowledged
+  TWI_TIMEOUT = 3,  // e.g. SCL held low by a slave
+  TWI_BUS_ERROR = 4 // SDA still held low after the recovery clocks
+} twi_status_t;
+
+/*! \brief START, the write bytes, a repeated START, the read bytes, STOP.
+ *
+ *  Either the write or the read part may be empty. The transaction has to
+ *  stay in memory until it completes.
+ */
+typedef struct twi_trans_struct
+{
+  twi_iface_t *iface;
+  uint8_t addr; // 7 bit slave address
+  const uint8_t *wrData;
+  uint8_t wrLen;
+  uint8_t *rdData;
+  uint8_t rdLen;
+  uint16_t timeoutMs;      // 0 for TWI_DEFAULT_TIMEOUT_MS
+  volatile uint8_t status; // twi_status_t
+  struct twi_trans_struct *next;
+} twi_trans_t;
+
+/*! \brief Setup the timer and semaphores. May be called more than once. */
+result_t twi_init(void);
+
+/*! \brief Serialize the access to the engine between tasks. */
+void twi_lock(void);
+void twi_unlock(void);
+
+/*! \brief Queue a list of transactions linked by next.
+ *
+ *  Returns immediately. Has to be called with twi_lock() held.
+ */
+void twi_submit(twi_trans_t *list);
 
-char twi_start_cond(twi_iface_t *iface);
-char twi_stop_cond(twi_iface_t *iface);
-char twi_write_data(twi_iface_t *iface, unsigned char slave_address, unsigned char* data, char bytes);
-char twi_read_data(twi_iface_t *iface, unsigned char slave_address, unsigned char* data, char bytes);
+/*! \brief Wait for a submitted list of transactions.
+ *
+ *  \return Status of the first failed transaction or TWI_OK.
+ */
+twi_status_t twi_wait(twi_trans_t *list);
 
+/*! \brief Lock, submit, wait and unlock. */
+twi_status_t twi_transfer(twi_trans_t *list);
 
+/*! \brief Stop the engine, pending transactions fail with TWI_TIMEOUT. */
+void twi_abort(void);
 
 #endif /* TWI_MASTER_H_ */
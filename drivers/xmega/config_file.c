@@ -1,6 +1,7 @@
 #include "config_file.h"
 
 #include "eeprom_driver.h"
+#include <avr/interrupt.h>
 #include <string.h>
 
 void ConfigFile_Init()
@@ -12,6 +13,8 @@ void ConfigFile_Init()
 
 result_t ConfigFile_Load(uint16_t id, void *pData, size_t size)
 {
+	// mapped EEPROM can't be read during a write
+	EEPROM_WaitForNVM();
 	memcpy(pData, (void *)(uintptr_t)(MAPPED_EEPROM_START + id), size);
 	return RESULT_OK;
 }
@@ -25,13 +28,26 @@ result_t ConfigFile_Save(uint16_t id, const void *pData, size_t size)
 		size_t k = size > EEPROM_PAGESIZE ? EEPROM_PAGESIZE : size;
 
 		// fill buffer, erase and write.
-		EEPROM_WaitForNVM();
-		for (uint8_t i = 0; i < k; ++i)
+		// Tasks may save different sections at the same time, so the page
+		// buffer is filled and the write started with interrupts disabled.
+		// The write itself runs with interrupts enabled.
+		for (;;)
 		{
-			EEPROM(page, i) = *p++;
+			EEPROM_WaitForNVM();
+			uint8_t sreg = SREG;
+			cli();
+			if (!(NVM.STATUS & NVM_NVMBUSY_bm))
+			{
+				for (uint8_t i = 0; i < k; ++i)
+				{
+					EEPROM(page, i) = *p++;
+				}
+				EEPROM_AtomicWritePage(page);
+				SREG = sreg;
+				break;
+			}
+			SREG = sreg;
 		}
-		EEPROM_ErasePage(page);
-		EEPROM_SplitWritePage(page);
 		EEPROM_WaitForNVM();
 
 		size -= k;
@@ -45,3 +45,20 @@ volatile DMA_CH_t *DMA_AllocChannel(void (*isr)(void *), void *pObj)
 	}
 	return NULL;
 }
+
+volatile DMA_CH_t *DMA_AllocChannelPair(void (*isr)(void *), void *pObj)
+{
+	for (uint8_t k = 0; k < 4; k += 2)
+	{
+		uint8_t pair = 3 << k;
+		if ((freeChannels & pair) != pair)
+			continue;
+		freeChannels &= ~pair;
+		DMA_Enable();
+		DMA.CTRL |= k ? DMA_DBUFMODE_CH23_gc : DMA_DBUFMODE_CH01_gc;
+		isrs[k] = isrs[k + 1] = isr;
+		isrObjs[k] = isrObjs[k + 1] = pObj;
+		return (volatile DMA_CH_t *)READ_IMMUTABLE_PTR(&channels[k]);
+	}
+	return NULL;
+}
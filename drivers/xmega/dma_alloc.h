@@ -14,4 +14,11 @@
  */
 volatile DMA_CH_t *DMA_AllocChannel(void (*isr)(void *), void *pObj);
 
+/**
+ *  Allocate a pair of channels (CH0/CH1 or CH2/CH3) set up for double
+ *  buffering. Return pointer to the first one, the second follows it,
+ *  or NULL, when no free pair available. Both use the same isr.
+ */
+volatile DMA_CH_t *DMA_AllocChannelPair(void (*isr)(void *), void *pObj);
+
 #endif // !_DMA_ALLOC_H__
@@ -7,6 +7,19 @@
 #include "app_cfg.h"
 #include "serial.h"
 
+/** Size of each of the two blocks received by DMA (SERIAL_USE_RX_DMA). */
+#ifndef SERIAL_RX_DMA_BLOCK
+#define SERIAL_RX_DMA_BLOCK 16
+#endif
+
+/** OS ticks without a complete block after which the bytes of the
+ *  incomplete one are passed to the input FIFO. Once a whole period passes
+ *  without any byte, the reader sleeps until the RX pin changes.
+ */
+#ifndef SERIAL_RX_DMA_FLUSH_TICKS
+#define SERIAL_RX_DMA_FLUSH_TICKS 1
+#endif
+
 #define PORTX_USART0_XCK (0x01 << 1)       // USART 0 Port C/D/E/F  pins settings
 #define PORTX_USART0_RX (0x01 << 2)
 #define PORTX_USART0_TX (0x01 << 3)
@@ -23,6 +36,7 @@ typedef struct USART_HwProp_struct
 	uint8_t rx_bm;
 	uint8_t tx_bm;
 	uint8_t triggerSource;
+	uint8_t rxTriggerSource;
 }
 __attribute__((aligned))
 USART_HwProp;
@@ -31,56 +45,56 @@ USART_HwProp const gHwProps[8] PROGMEM =
 {
 
 #ifdef XMEGA_USART_ENABLE_USARTC0
-	{ &USARTC0, &PORTC, PORTX_USART0_XCK, PORTX_USART0_RX, PORTX_USART0_TX, DMA_CH_TRIGSRC_USARTC0_DRE_gc },
+	{ &USARTC0, &PORTC, PORTX_USART0_XCK, PORTX_USART0_RX, PORTX_USART0_TX, DMA_CH_TRIGSRC_USARTC0_DRE_gc, DMA_CH_TRIGSRC_USARTC0_RXC_gc },
 #define USARTC0_ENABLED 1
 #else
 #define USARTC0_ENABLED 0
 #endif
 
 #ifdef XMEGA_USART_ENABLE_USARTC1
-	{ &USARTC1, &PORTC, PORTX_USART1_XCK, PORTX_USART1_RX, PORTX_USART1_TX, DMA_CH_TRIGSRC_USARTC1_DRE_gc },
+	{ &USARTC1, &PORTC, PORTX_USART1_XCK, PORTX_USART1_RX, PORTX_USART1_TX, DMA_CH_TRIGSRC_USARTC1_DRE_gc, DMA_CH_TRIGSRC_USARTC1_RXC_gc },
 #define USARTC1_ENABLED 1
 #else
 #define USARTC1_ENABLED 0
 #endif
 
 #ifdef XMEGA_USART_ENABLE_USARTD0
-	{ &USARTD0, &PORTD, PORTX_USART0_XCK, PORTX_USART0_RX, PORTX_USART0_TX, DMA_CH_TRIGSRC_USARTD0_DRE_gc },
+	{ &USARTD0, &PORTD, PORTX_USART0_XCK, PORTX_USART0_RX, PORTX_USART0_TX, DMA_CH_TRIGSRC_USARTD0_DRE_gc, DMA_CH_TRIGSRC_USARTD0_RXC_gc },
 #define USARTD0_ENABLED 1
 #else
 #define USARTD0_ENABLED 0
 #endif
 
 #ifdef XMEGA_USART_ENABLE_USARTD1
-	{ &USARTD1, &PORTD, PORTX_USART1_XCK, PORTX_USART1_RX, PORTX_USART1_TX, DMA_CH_TRIGSRC_USARTD1_DRE_gc },
+	{ &USARTD1, &PORTD, PORTX_USART1_XCK, PORTX_USART1_RX, PORTX_USART1_TX, DMA_CH_TRIGSRC_USARTD1_DRE_gc, DMA_CH_TRIGSRC_USARTD1_RXC_gc },
 #define USARTD1_ENABLED 1
 #else
 #define USARTD1_ENABLED 0
 #endif
 
 #ifdef XMEGA_USART_ENABLE_USARTE0
-	{ &USARTE0, &PORTE, PORTX_USART0_XCK, PORTX_USART0_RX, PORTX_USART0_TX, DMA_CH_TRIGSRC_USARTE0_DRE_gc },
+	{ &USARTE0, &PORTE, PORTX_USART0_XCK, PORTX_USART0_RX, PORTX_USART0_TX, DMA_CH_TRIGSRC_USARTE0_DRE_gc, DMA_CH_TRIGSRC_USARTE0_RXC_gc },
 #define USARTE0_ENABLED 1
 #else
 #define USARTE0_ENABLED 0
 #endif
 
 #ifdef XMEGA_USART_ENABLE_USARTE1
-	{ &USARTE1, &PORTE, PORTX_USART1_XCK, PORTX_USART1_RX, PORTX_USART1_TX, DMA_CH_TRIGSRC_USARTE1_DRE_gc },
+	{ &USARTE1, &PORTE, PORTX_USART1_XCK, PORTX_USART1_RX, PORTX_USART1_TX, DMA_CH_TRIGSRC_USARTE1_DRE_gc, DMA_CH_TRIGSRC_USARTE1_RXC_gc },
 #define USARTE1_ENABLED 1
 #else
 #define USARTE1_ENABLED 0
 #endif
 
 #ifdef XMEGA_USART_ENABLE_USARTF0
-	{ &USARTF0, &PORTF, PORTX_USART0_XCK, PORTX_USART0_RX, PORTX_USART0_TX, DMA_CH_TRIGSRC_USARTF0_DRE_gc },
+	{ &USARTF0, &PORTF, PORTX_USART0_XCK, PORTX_USART0_RX, PORTX_USART0_TX, DMA_CH_TRIGSRC_USARTF0_DRE_gc, DMA_CH_TRIGSRC_USARTF0_RXC_gc },
 #define USARTF0_ENABLED 1
 #else
 #define USARTF0_ENABLED 0
 #endif
 
 #ifdef XMEGA_USART_ENABLE_USARTF1
-	{ &USARTF1, &PORTF, PORTX_USART1_XCK, PORTX_USART1_RX, PORTX_USART1_TX, DMA_CH_TRIGSRC_USARTF1_DRE_gc }
+	{ &USARTF1, &PORTF, PORTX_USART1_XCK, PORTX_USART1_RX, PORTX_USART1_TX, DMA_CH_TRIGSRC_USARTF1_DRE_gc, DMA_CH_TRIGSRC_USARTF1_RXC_gc }
 #define USARTF1_ENABLED 1
 #else
 #define USARTF1_ENABLED 0
@@ -215,11 +229,20 @@ typedef struct SerialInfo_struct
 	MT_SemType inFifoSem;
 	MT_SemType outFifoSem;
 	volatile DMA_CH_t *pDMA;
+	volatile DMA_CH_t *pRxDMA; // first channel of the double buffered pair
+	uint8_t rxActive; // block being received
+	uint8_t rxPos; // bytes of the active block already in the input FIFO
+	volatile PORT_t *pRxPort; // INT1 of the RX pin wakes the idle reader
+	uint16_t rxOverruns;
 }
 SerialInfo;
 
 static SerialInfo serialInfo[8];
 
+// only one port may receive by DMA
+static uint8_t rxBuf[2][SERIAL_RX_DMA_BLOCK];
+static SerialInfo *pRxDMAOwner;
+
 #define SERIAL_RXC_ISR(_num, _name) \
 MT_ISR(USART ## _name ## _RXC_vect) \
 { \
@@ -252,6 +275,27 @@ SERIAL_RXC_ISR(USARTF0_NUM, F0)
 SERIAL_RXC_ISR(USARTF1_NUM, F1)
 #endif
 
+// the RX pin of the port receiving by DMA changed
+#define SERIAL_RX_WAKE_ISR(_port) \
+MT_ISR(PORT ## _port ## _INT1_vect) \
+{ \
+	pRxDMAOwner->pRxPort->INTCTRL &= (uint8_t)(~PORT_INT1LVL_gm); \
+	MT_SEM_POST(pRxDMAOwner->inFifoSem); \
+}
+
+#if defined(XMEGA_USART_ENABLE_USARTC0) || defined(XMEGA_USART_ENABLE_USARTC1)
+SERIAL_RX_WAKE_ISR(C)
+#endif
+#if defined(XMEGA_USART_ENABLE_USARTD0) || defined(XMEGA_USART_ENABLE_USARTD1)
+SERIAL_RX_WAKE_ISR(D)
+#endif
+#if defined(XMEGA_USART_ENABLE_USARTE0) || defined(XMEGA_USART_ENABLE_USARTE1)
+SERIAL_RX_WAKE_ISR(E)
+#endif
+#if defined(XMEGA_USART_ENABLE_USARTF0) || defined(XMEGA_USART_ENABLE_USARTF1)
+SERIAL_RX_WAKE_ISR(F)
+#endif
+
 #define SERIAL_TXC_ISR(_num, _name) \
 MT_ISR(USART ## _name ## _TXC_vect) \
 { \
@@ -300,12 +344,138 @@ static void Serial_DMA_ISR(void *pObj)
 	((SerialInfo *)pObj)->pUsart->CTRLA |= USART_TXCINTLVL_HI_gc;
 }
 
+/** \brief Pass the newly received bytes of the active block to the input FIFO.
+ *
+ *  Called with interrupts disabled. Bytes not fitting in the FIFO are lost.
+ */
+static void Serial_RxMove(SerialInfo *pInfo, uint8_t end)
+{
+	uint8_t pos = pInfo->rxPos;
+	if (end <= pos)
+		return;
+	unsigned n = end - pos;
+	if (ByteFifo_Write(pInfo->pInFifo, &rxBuf[pInfo->rxActive][pos], n) != n)
+		pInfo->rxOverruns++;
+	pInfo->rxPos = end;
+}
+
+static void Serial_RxDMA_ISR(void *pObj)
+{
+	SerialInfo *pInfo = (SerialInfo *)pObj;
+	// both blocks may have completed if the interrupt came late
+	for (uint8_t k = 0; k < 2; k++)
+	{
+		volatile DMA_CH_t *pDMA = pInfo->pRxDMA + pInfo->rxActive;
+		if (!(pDMA->CTRLB & (DMA_CH_TRNIF_bm | DMA_CH_ERRIF_bm)))
+			break;
+		// an error, or the other channel had no buffer ready to take over
+		if ((pDMA->CTRLB & DMA_CH_ERRIF_bm) || k)
+			pInfo->rxOverruns++;
+		pDMA->CTRLB |= DMA_CH_TRNIF_bm | DMA_CH_ERRIF_bm;
+		Serial_RxMove(pInfo, SERIAL_RX_DMA_BLOCK);
+		pInfo->rxPos = 0;
+		pInfo->rxActive ^= 1;
+		// ready to take over once the other block is full
+		pDMA->TRFCNT = SERIAL_RX_DMA_BLOCK;
+		DMA_EnableChannel(pDMA);
+	}
+	MT_SEM_POST(pInfo->inFifoSem);
+}
+
+/** \brief Pass what has arrived of the incomplete block to the input FIFO.
+ *
+ *  \return false if nothing has arrived since the last call.
+ */
+static bool Serial_RxFlush(SerialInfo *pInfo)
+{
+	bool received = true;
+	uint8_t sreg = SREG;
+	cli();
+	volatile DMA_CH_t *pDMA = pInfo->pRxDMA + pInfo->rxActive;
+	// a complete block is left to the interrupt
+	if (!(pDMA->CTRLB & DMA_CH_TRNIF_bm))
+	{
+		uint8_t end = SERIAL_RX_DMA_BLOCK - pDMA->TRFCNT;
+		received = end > pInfo->rxPos;
+		Serial_RxMove(pInfo, end);
+	}
+	SREG = sreg;
+	return received;
+}
+
+/** \brief Arm the wake-up on the RX pin.
+ *
+ *  The DMA reads the data register, which clears the RXC flag before an
+ *  interrupt could be relied on, so the first edge of a start bit wakes the
+ *  reader instead. A byte already under way is caught by the next flush.
+ *
+ *  \return true if it was armed already, no byte has started since.
+ */
+static bool Serial_RxArm(SerialInfo *pInfo)
+{
+	volatile PORT_t *pPort = pInfo->pRxPort;
+	uint8_t sreg = SREG;
+	cli();
+	bool armed = pPort->INTCTRL & PORT_INT1LVL_gm;
+	if (!armed)
+	{
+		pPort->INTFLAGS = PORT_INT1IF_bm;
+		pPort->INTCTRL |= PORT_INT1LVL_HI_gc;
+	}
+	SREG = sreg;
+	return armed;
+}
+
+static void Serial_RxDMA_Start(uint8_t usart)
+{
+	SerialInfo *pInfo = &serialInfo[usart];
+	for (uint8_t i = 0; i < 2; i++)
+	{
+		volatile DMA_CH_t *pDMA = pInfo->pRxDMA + i;
+		DMA_DisableChannel(pDMA);
+		DMA_SetupBlock(
+			pDMA,
+			(void *)&PROP_USART(&gHwProps[usart])->DATA,
+			DMA_CH_SRCRELOAD_NONE_gc,
+			DMA_CH_SRCDIR_FIXED_gc,
+			rxBuf[i],
+			DMA_CH_DESTRELOAD_BLOCK_gc,
+			DMA_CH_DESTDIR_INC_gc,
+			SERIAL_RX_DMA_BLOCK,
+			DMA_CH_BURSTLEN_1BYTE_gc,
+			0,
+			false
+		);
+		DMA_EnableSingleShot(pDMA);
+		// USART Trigger source, Receive Complete
+		DMA_SetTriggerSource(pDMA, pgm_read_byte_near(&gHwProps[usart].rxTriggerSource));
+		DMA_SetIntLevel(pDMA, DMA_CH_TRNINTLVL_HI_gc, DMA_CH_ERRINTLVL_HI_gc);
+	}
+	pInfo->rxActive = 0;
+	pInfo->rxPos = 0;
+	pInfo->pRxPort = PROP_PORT(&gHwProps[usart]);
+	pInfo->pRxPort->INTCTRL &= (uint8_t)(~PORT_INT1LVL_gm);
+	pInfo->pRxPort->INT1MASK = pgm_read_byte_near(&gHwProps[usart].rx_bm);
+	// the second channel is enabled by the hardware when the first completes
+	DMA_EnableChannel(pInfo->pRxDMA);
+}
+
 result_t Serial_Init(uint8_t usart, uint32_t baudrate, ByteFifo *pInFifo, ByteFifo *pOutFifo, int options)
 {
-	if (options & ~SERIAL_USE_TX_DMA)
+	if (options & ~(SERIAL_USE_TX_DMA | SERIAL_USE_RX_DMA))
 	{
 		return S("Serial_Init: Unsupported options");
 	}
+	if (options & SERIAL_USE_RX_DMA)
+	{
+		if (!pInFifo)
+			return S("Serial_Init: RX DMA needs pInFifo");
+		if (pRxDMAOwner && pRxDMAOwner != &serialInfo[usart])
+			return S("Serial_Init: RX DMA already in use");
+		if (!serialInfo[usart].pRxDMA && !(serialInfo[usart].pRxDMA = DMA_AllocChannelPair(&Serial_RxDMA_ISR, (void *)&serialInfo[usart])))
+			return S("Serial_Init: No DMA channels available");
+		pRxDMAOwner = &serialInfo[usart];
+	}
 	if (options & SERIAL_USE_TX_DMA)
 	{
 		if (!(serialInfo[usart].pDMA = DMA_AllocChannel(&Serial_DMA_ISR, (void *)&serialInfo[usart])))
@@ -327,7 +497,11 @@ result_t Serial_Init(uint8_t usart, uint32_t baudrate, ByteFifo *pInFifo, ByteFi
 	{
 		return S("Serial_Init: pOutFifo is needless when using DMA");
 	}
-	if (pInFifo)
+	if (pInFifo && serialInfo[usart].pRxDMA)
+	{
+		Serial_RxDMA_Start(usart);
+	}
+	else if (pInFifo)
 	{
 		pUsart->CTRLA |= USART_RXCINTLVL_HI_gc;
 	}
@@ -383,6 +557,26 @@ void Serial_Write(uint8_t usart, const void *buf, size_t length)
 
 char Serial_Getc(uint8_t usart)
 {
+	SerialInfo *pInfo = &serialInfo[usart];
+	if (pInfo->pRxDMA)
+	{
+		uint16_t ticks = SERIAL_RX_DMA_FLUSH_TICKS;
+		for (;;)
+		{
+			uint8_t sreg = SREG;
+			cli();
+			int c = ByteFifo_Get(pInfo->pInFifo);
+			SREG = sreg;
+			if (c != BYTEFIFO_EOF)
+				return c;
+			// nothing for a while, take the bytes of the incomplete block,
+			// sleep without a timeout once a whole period brought nothing
+			if (MT_SEM_PEND(pInfo->inFifoSem, ticks))
+				ticks = SERIAL_RX_DMA_FLUSH_TICKS;
+			else if (!Serial_RxFlush(pInfo) && Serial_RxArm(pInfo))
+				ticks = 0;
+		}
+	}
 	MT_SEM_PEND(serialInfo[usart].inFifoSem, 0);
 	USART_DISABLE_INTERRUPT(usart, RXC);
 	char q = ByteFifo_Get(serialInfo[usart].pInFifo);
@@ -390,6 +584,13 @@ char Serial_Getc(uint8_t usart)
 	return q;
 }
 
+uint16_t Serial_GetRxOverruns(uint8_t usart)
+{
+	uint16_t n;
+	MT_ATOMIC_EXPR(n = serialInfo[usart].rxOverruns);
+	return n;
+}
+
 /*
  * Debug console implementation
  */
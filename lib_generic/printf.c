@@ -56,6 +56,8 @@ static char *ksprintn(myuintmax_t num, uint8_t base, bool upper, uint8_t *pLen,
   return p;
 }
 
+#ifdef PRINTF_ENABLE_FLOAT
+
 typedef union {
   uint32_t L;
   float F;
@@ -114,6 +116,8 @@ static char *ftoa(float f, char *outbuf) {
   return p - 1;
 }
 
+#endif // PRINTF_ENABLE_FLOAT
+
 int kvprintf_P(immutable_str fmt, void (*putChar)(void *pObj, char c),
                void *pObj, va_list ap) {
 #define LFLAG 0x80
@@ -143,6 +147,7 @@ int kvprintf_P(immutable_str fmt, void (*putChar)(void *pObj, char c),
   uint8_t tmp;
   int width, dwidth;
   bool upper;
+  bool fixed;
   char padc;
   bool stop = false;
   int retval = 0;
@@ -163,6 +168,7 @@ int kvprintf_P(immutable_str fmt, void (*putChar)(void *pObj, char c),
     width = 0;
     percent = fmt - 1;
     upper = false;
+    fixed = false;
     flags = 0;
 
   reswitch:
@@ -225,6 +231,14 @@ int kvprintf_P(immutable_str fmt, void (*putChar)(void *pObj, char c),
     case 'i':
       base = 10;
       goto handle_sign;
+    case 'k':
+      // signed integer scaled by 10^precision, e.g. %.3k of -1250 is -1.250
+      base = 10;
+      fixed = true;
+      if (dwidth > (int)MAXNBUF - 3)
+        dwidth = MAXNBUF - 3;
+      goto handle_sign;
+#ifdef PRINTF_ENABLE_FLOAT
     case 'f': {
       float g = va_arg(ap, double);
       nbuf[0] = 0;
@@ -234,6 +248,7 @@ int kvprintf_P(immutable_str fmt, void (*putChar)(void *pObj, char c),
           PUTCHAR(*p--);
       }
     } break;
+#endif
     case 'h':
       if (flags & HFLAG) {
         flags &= (uint8_t)~HFLAG;
@@ -340,6 +355,13 @@ int kvprintf_P(immutable_str fmt, void (*putChar)(void *pObj, char c),
       }
       nbuf[0] = '\0';
       p = ksprintn(num, base, upper, &tmp, nbuf + 1);
+      if (fixed && dwidth > 0) {
+        // leading zeros up to the first integer digit, then the point
+        while (tmp <= dwidth)
+          nbuf[++tmp] = '0';
+        p = nbuf + tmp;
+        tmp++;
+      }
       if ((flags & SHARP) && num != 0) {
         if (base == 8)
           tmp++;
@@ -368,8 +390,11 @@ int kvprintf_P(immutable_str fmt, void (*putChar)(void *pObj, char c),
         while (width--)
           PUTCHAR(padc);
 
-      while (*p)
+      while (*p) {
+        if (fixed && p == nbuf + dwidth)
+          PUTCHAR('.');
         PUTCHAR(*p--);
+      }
 
       if ((flags & LADJUST) && width && (width -= tmp) > 0)
         while (width--)
@@ -448,6 +473,7 @@ static char buf[1024];
 #warning fix testprintf
 
 void testPrintf(void) {
+#ifdef PRINTF_ENABLE_FLOAT
   int cnt;
   int res;
   char c = 'A';
@@ -478,6 +504,10 @@ void testPrintf(void) {
   assert(0 ==
          strcmp(buf, "--12.125%truncA   123+009865  1001000110100   "
                      "410x000ABC65535-1      testtest      01770x12ef%q%b"));
+#endif
+
+  snprintf_P(buf, 1024, "%.3lk %.3k %.2k %k", 123456L, -1250, 5, 42);
+  assert(0 == strcmp(buf, "123.456 -1.250 0.05 42"));
 
   printf("printf test passed\n\n");
 }
@@ -25,6 +25,11 @@ extern "C" {
  *  \param[in]  pObj      Pointer passed as second argument to putChar.
  *  \param[in]  ap        Additional arguments.
  *
+ *  Besides the usual conversions, %k prints a signed fixed point number: the
+ *  integer argument divided by 10 to the power of the precision, e.g. %.2k of
+ *  -305 is -3.05. It avoids the float conversion (%f) in the callers, which
+ *  is only compiled in with PRINTF_ENABLE_FLOAT defined.
+ *
  *  \return     Number of characters printed.
  */
 int kvprintf_P(immutable_str fmt, void (*putChar)(void *pObj, char c),